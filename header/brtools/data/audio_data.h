@@ -2,14 +2,245 @@
 #define BRTOOLS_DATA_AUDIO_DATA_H
 #pragma once
 
+#include <atomic>
+#include <cstdint>      // int16_t
+#include <cstddef>      // size_t
+#include <limits>       // numeric_limits
+#include <stdexcept>    // out_of_range, length_error
+#include <utility>      // swap
+
 namespace brtools
 {
 namespace data
 {
+    /**
+     * Type of the samples of audio_data.
+     */
+    enum class sample_format
+    {
+        pcm16,
+        float32,
+    };
+
+    template<typename _Sample>
+    struct sample_format_of;
+
+    template<>
+    struct sample_format_of<int16_t>
+    {   static constexpr sample_format value = sample_format::pcm16;   };
+
+    template<>
+    struct sample_format_of<float>
+    {   static constexpr sample_format value = sample_format::float32;   };
+
+    /**
+     * Audio decoded from any source, as frames of one sample per channel.
+     */
     struct audio_data
     {
         virtual ~audio_data() = default;
+
+        virtual sample_format format() const = 0;
+        virtual size_t channel_count() const = 0;
+        virtual size_t frame_count() const = 0;
     };
+
+    namespace detail
+    {
+        /**
+         * Reference-counted storage of planar_audio_data, which starts at
+         * audio_block_alignment past the block itself.
+         */
+        struct audio_block
+        {
+            std::atomic<size_t> references;
+            size_t              capacity;
+            void*               allocation;
+        };
+
+        constexpr size_t audio_block_alignment = 64;
+
+        /**
+         * Gets a block with room for at least the given bytes of samples, and
+         * one reference. Blocks up to small_audio_block_size bytes are reused
+         * from a pool, so decoding block after block does not allocate once
+         * the pool is warm.
+         */
+        audio_block* acquire_audio_block(size_t bytes);
+
+        /**
+         * Returns a block whose last reference is dropped to the pool, or
+         * frees it.
+         */
+        void release_audio_block(audio_block*);
+
+        constexpr size_t small_audio_block_size = size_t(1) << 20;
+    }
+
+    /**
+     * Planar audio, with the samples of each channel contiguous.
+     *
+     * Each channel starts on a 64-byte boundary, so channels can be processed
+     * with aligned vector loads of any width up to 512 bits. The channels of
+     * a buffer share one block of storage, which copies and slices refer to
+     * rather than copy. Writes through one are seen by all of them, so a
+     * decoder can write its output into a slice of a larger buffer.
+     *
+     * @tparam _Sample int16_t or float.
+     */
+    template<typename _Sample>
+    class planar_audio_data : public audio_data
+    {
+    public:
+        using sample_type = _Sample;
+
+        static constexpr size_t alignment = detail::audio_block_alignment;
+
+    public:
+        planar_audio_data() noexcept
+        : _m_block(nullptr), _m_samples(nullptr), _m_channels(0), _m_frames(0), _m_stride(0)
+        {}
+
+        /**
+         * Allocates a buffer of the given size. The samples are not
+         * initialized.
+         *
+         * @throws std::length_error if the samples would not fit in memory.
+         */
+        planar_audio_data(const size_t channels, const size_t frames)
+        : planar_audio_data()
+        {
+            if (channels == 0 || frames == 0)
+            {
+                _m_channels = channels;
+                _m_frames   = frames;
+                return;
+            }
+
+            // the block takes up to two lines beyond the samples
+            constexpr auto max_samples = (std::numeric_limits<size_t>::max() - 2 * alignment) / sizeof(_Sample);
+            if (frames > max_samples)
+            {
+                throw std::length_error("The audio data is too large.");
+            }
+
+            // pads every channel to the alignment
+            constexpr auto samples_per_line = alignment / sizeof(_Sample);
+            const auto stride = (frames + samples_per_line - 1) / samples_per_line * samples_per_line;
+            if (stride > max_samples / channels)
+            {
+                throw std::length_error("The audio data is too large.");
+            }
+
+            _m_block    = detail::acquire_audio_block(channels * stride * sizeof(_Sample));
+            _m_samples  = reinterpret_cast<_Sample*>(reinterpret_cast<char*>(_m_block) + alignment);
+            _m_channels = channels;
+            _m_frames   = frames;
+            _m_stride   = stride;
+        }
+
+        planar_audio_data(const planar_audio_data& other) noexcept
+        : _m_block(other._m_block)
+        , _m_samples(other._m_samples)
+        , _m_channels(other._m_channels)
+        , _m_frames(other._m_frames)
+        , _m_stride(other._m_stride)
+        {
+            if (_m_block != nullptr)
+            {
+                _m_block->references.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        planar_audio_data(planar_audio_data&& other) noexcept
+        : planar_audio_data()
+        {
+            swap(other);
+        }
+
+        planar_audio_data& operator=(planar_audio_data other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        ~planar_audio_data() override
+        {
+            if (_m_block != nullptr && _m_block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                detail::release_audio_block(_m_block);
+            }
+        }
+
+        void swap(planar_audio_data& other) noexcept
+        {
+            std::swap(_m_block, other._m_block);
+            std::swap(_m_samples, other._m_samples);
+            std::swap(_m_channels, other._m_channels);
+            std::swap(_m_frames, other._m_frames);
+            std::swap(_m_stride, other._m_stride);
+        }
+
+    public:
+        sample_format format() const override
+        {   return sample_format_of<_Sample>::value;   }
+
+        size_t channel_count() const override
+        {   return _m_channels;   }
+
+        size_t frame_count() const override
+        {   return _m_frames;   }
+
+        /**
+         * The frame_count samples of the channel, which must be below
+         * channel_count. Aligned to alignment unless this is a slice starting
+         * within a line.
+         */
+        _Sample* channel(const size_t index)
+        {   return _m_samples + index * _m_stride;   }
+
+        const _Sample* channel(const size_t index) const
+        {   return _m_samples + index * _m_stride;   }
+
+        /**
+         * Refers to frame_count frames starting at first_frame, sharing the
+         * samples of this buffer.
+         *
+         * @throws std::out_of_range if the frames are not within this buffer.
+         */
+        planar_audio_data slice(const size_t first_frame, const size_t frame_count) const
+        {
+            if (first_frame > _m_frames || frame_count > _m_frames - first_frame)
+            {
+                throw std::out_of_range("The slice is out of range of the audio data.");
+            }
+
+            planar_audio_data result(*this);
+            result._m_samples += first_frame;
+            result._m_frames   = frame_count;
+            return result;
+        }
+
+        /**
+         * Whether no other buffer or slice refers to the samples.
+         */
+        bool unique() const
+        {   return _m_block == nullptr || _m_block->references.load(std::memory_order_acquire) == 1;   }
+
+    private:
+        detail::audio_block* _m_block;
+        _Sample*             _m_samples;
+        size_t               _m_channels;
+        size_t               _m_frames;
+
+        /**
+         * Samples from the start of one channel to the next.
+         */
+        size_t               _m_stride;
+    };
+
+    using pcm16_audio_data   = planar_audio_data<int16_t>;
+    using float32_audio_data = planar_audio_data<float>;
 }
 }
 
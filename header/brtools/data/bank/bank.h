@@ -0,0 +1,120 @@
+#ifndef BRTOOLS_DATA_BANK_BANK_H
+#define BRTOOLS_DATA_BANK_BANK_H
+#pragma once
+
+#include <iosfwd>   // for forward-declaration of istream
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t, int32_t
+#include <cstddef>  // for size_t
+#include <vector>
+
+namespace brtools
+{
+namespace data
+{
+namespace bank
+{
+    /**
+     * The envelope a region is played with, as stored.
+     */
+    struct envelope
+    {
+        uint8_t attack;
+        uint8_t decay;
+        uint8_t sustain;
+        uint8_t release;
+        uint8_t hold;
+    };
+
+    /**
+     * The wave and playback parameters a range of notes and velocities of an
+     * instrument plays.
+     */
+    struct region
+    {
+        /**
+         * The index of the wave in the wave archive of the bank.
+         */
+        int32_t  wave_index;
+        envelope adsr;
+
+        /**
+         * The note the wave sounds at when played at its own sample rate.
+         */
+        uint8_t  original_key;
+        uint8_t  volume;
+        uint8_t  pan;
+        float    tune;
+    };
+
+    /**
+     * Represents the instruments of an RBNK file, which program events select
+     * by program_no.
+     *
+     * In the file, an instrument splits the notes into regions through a
+     * table, and each of those may split the velocities through another,
+     * whose entries are regions. The tables are flattened when the bank is made, so that finding the
+     * region of a note takes no search. Notes share rows of velocities,
+     * since few instruments layer velocities differently for every note.
+     */
+    class bank
+    {
+    public:
+        /**
+         * The number of notes and of velocities.
+         */
+        static constexpr size_t key_count = 128;
+
+        /**
+         * @throws error::integrity_error if the file is not a well-formed RBNK,
+         *                                or nests tables below velocities.
+         */
+        static bank make_bank(std::istream&);
+
+        size_t instrument_count() const;
+
+        /**
+         * The region a note of the given instrument plays, or nullptr if the
+         * instrument is missing or has no region there. Velocities past the
+         * last are treated as the last.
+         *
+         * @param note Must be below key_count, as in note_on events.
+         */
+        const region* find(size_t program_no, uint8_t note, uint32_t velocity) const
+        {
+            if (program_no >= _m_instrument_count)
+            {
+                return nullptr;
+            }
+            const auto row  = _m_key_rows[program_no * key_count + note];
+            const auto cell = _m_rows[row * key_count + (velocity < key_count ? velocity : key_count - 1)];
+            return cell == no_region ? nullptr : &_m_regions[cell];
+        }
+
+        /**
+         * Every distinct region of the bank.
+         */
+        const std::vector<region>& regions() const;
+
+    private:
+        bank() = default;
+
+        static constexpr uint16_t no_region = 0xFFFF;
+
+        size_t              _m_instrument_count = 0;
+        std::vector<region> _m_regions;
+
+        /**
+         * The row of velocities of every note of every instrument, by
+         * instrument then note. Row 0 has no regions.
+         */
+        std::vector<uint16_t> _m_key_rows;
+
+        /**
+         * The region of every velocity of every row, by row then velocity.
+         */
+        std::vector<uint16_t> _m_rows;
+    };
+}
+}
+}
+#endif
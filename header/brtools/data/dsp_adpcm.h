@@ -0,0 +1,98 @@
+#ifndef BRTOOLS_DATA_DSP_ADPCM_H
+#define BRTOOLS_DATA_DSP_ADPCM_H
+#pragma once
+
+#include <cstdint>  // int16_t
+#include <cstddef>  // size_t
+#include <vector>
+
+#include <brtools/data/audio_data.h>
+
+namespace brtools
+{
+namespace data
+{
+    /**
+     * Nintendo DSP-ADPCM, the encoding of nearly all wave data in RWAV, RWAR
+     * and RSTM files.
+     *
+     * Samples are coded in frames of 8 bytes: a header byte whose high
+     * nibble selects one of 8 coefficient pairs and whose low nibble is the
+     * log2 of the scale, followed by 14 signed 4-bit samples, high nibble
+     * first. Each sample is predicted from the two decoded before it.
+     */
+    namespace dsp_adpcm
+    {
+        constexpr size_t frame_size        = 8;
+        constexpr size_t samples_per_frame = 14;
+
+        /**
+         * The 8 coefficient pairs of a channel, as stored in the files.
+         */
+        struct coefficients
+        {
+            int16_t pairs[8][2];
+        };
+
+        /**
+         * The two samples decoded last, which the next ones are predicted
+         * from. Files store it at the start of a channel, of its loop, and of
+         * each RSTM block.
+         */
+        struct history
+        {
+            int16_t previous        = 0;
+            int16_t before_previous = 0;
+        };
+
+        /**
+         * Bytes of the frames that hold the given number of samples.
+         */
+        constexpr size_t frame_bytes(const size_t sample_count)
+        {   return (sample_count + samples_per_frame - 1) / samples_per_frame * frame_size;   }
+
+        /**
+         * The number of samples before the given nibble address, as files
+         * store positions within DSP-ADPCM data; the addresses count the two
+         * nibbles of every frame header as well.
+         */
+        constexpr size_t nibble_address_to_samples(const size_t address)
+        {   return address / (2 * frame_size) * samples_per_frame + (address % (2 * frame_size) > 2 ? address % (2 * frame_size) - 2 : 0);   }
+
+        /**
+         * Decodes sample_count samples of one channel, starting at the start
+         * of a frame, and advances the history past them. Frames are decoded
+         * with vector instructions where available, with output identical to
+         * the scalar decoder.
+         *
+         * @param frames Must hold frame_bytes(sample_count) bytes.
+         *
+         * @throws error::integrity_error if a frame selects a coefficient
+         *                                pair past the 8.
+         */
+        void decode(const char* frames, size_t sample_count, const coefficients&, history&, int16_t* samples);
+
+        /**
+         * The frames, coefficients and history of a channel to decode.
+         */
+        struct channel
+        {
+            const char*  frames;
+            coefficients coefs;
+            history      hist;
+        };
+
+        /**
+         * Decodes sample_count samples of every channel into one buffer, and
+         * advances the frames and history of the channels past them, so that
+         * decoding can go on where it stopped if sample_count is a multiple
+         * of samples_per_frame.
+         *
+         * @see decode(const char*, size_t, const coefficients&, history&, int16_t*)
+         */
+        pcm16_audio_data decode(std::vector<channel>& channels, size_t sample_count);
+    }
+}
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef BRTOOLS_DATA_ENCODING_H
+#define BRTOOLS_DATA_ENCODING_H
+#pragma once
+
+#include <cstdint>  // uint8_t
+
+namespace brtools
+{
+namespace data
+{
+    /**
+     * How the samples of a stream or a wave are encoded, with the values
+     * that RSTM and RWAV files store.
+     */
+    enum class encoding : uint8_t
+    {
+        pcm8  = 0,
+        pcm16 = 1,
+        adpcm = 2,
+    };
+}
+}
+
+#endif
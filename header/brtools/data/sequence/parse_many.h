@@ -0,0 +1,64 @@
+#ifndef BRTOOLS_DATA_SEQUENCE_PARSE_MANY_H
+#define BRTOOLS_DATA_SEQUENCE_PARSE_MANY_H
+#pragma once
+
+#include <cstddef>    // for size_t
+#include <exception>  // for exception_ptr
+#include <functional> // for function
+#include <string>
+#include <vector>
+#include <brtools/data/sequence/sequence.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace sequence
+{
+    struct parse_options
+    {
+        /**
+         * Number of threads parsing files, including the calling thread.
+         * 0 stands for the number of hardware threads.
+         */
+        size_t thread_count = 0;
+
+        /**
+         * Maximum number of files held in memory at once. A file is held from
+         * the time it is opened until its callback returns. 0 stands for the
+         * number of threads.
+         */
+        size_t max_files_in_flight = 0;
+
+        /**
+         * Decoding mode passed to sequence::make_sequence for every file.
+         * Parallel decoding rarely pays off here, since files are already
+         * parsed concurrently.
+         */
+        sequence::decoding decoding = sequence::decoding::serial;
+    };
+
+    /**
+     * Parses every file in paths concurrently. Each file is read into memory
+     * as a whole and parsed with sequence::make_sequence.
+     *
+     * Callbacks are invoked in the order files complete, which is generally
+     * not the order of paths, and never concurrently with each other.
+     *
+     * @param on_parsed Called with the index of the file in paths and the
+     *                  sequence parsed from it, which may be moved from.
+     *
+     * @param on_error  Called with the index of the file in paths and the
+     *                  exception thrown while opening, reading or parsing it.
+     *                  The remaining files are still parsed.
+     *
+     * Exceptions thrown by the callbacks themselves stop the batch and are
+     * rethrown once the files in flight are done.
+     */
+    void parse_many(const std::vector<std::string>& paths, const parse_options& options,
+                    const std::function<void(size_t index, sequence&)>& on_parsed,
+                    const std::function<void(size_t index, std::exception_ptr)>& on_error);
+}
+}
+}
+#endif
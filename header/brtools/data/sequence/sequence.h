@@ -3,9 +3,16 @@
 #pragma once
 
 #include <memory>   // for unique_ptr
+#include <utility>  // for move
 #include <iosfwd>   // for forward-declaration of istream
+#include <cstdint>  // for uint32_t
+#include <cstddef>  // for size_t
+#include <functional> // for function
 #include <string>
 #include <list>
+#include <map>
+#include <stack>
+#include <vector>
 #include <unordered_map>
 #include <brtools/util/unit_testable.h>
 #include <brtools/data/playable.h>
@@ -31,12 +38,237 @@ namespace sequence
         using event_const_iterator = event_container::const_iterator;
         using event_iterator       = event_container::iterator;
 
-        static sequence make_sequence(std::istream&);
+        /**
+         * Snapshot of the traversal state at an event boundary, from which
+         * traversal can be resumed without replaying the preceding events.
+         *
+         * State kept inside the visitor itself, such as loop counters or
+         * sounding voices, is not captured; visitors driving a resumed
+         * traversal should derive it from the events that follow.
+         */
+        struct checkpoint
+        {
+            /**
+             * Ticks elapsed before the next event, counted from wait events.
+             */
+            uint32_t tick = 0;
+
+            /**
+             * The event to be visited next.
+             */
+            event_const_iterator next;
+
+            std::stack<event_const_iterator> call_stack;
+            std::stack<event_const_iterator> loop_stack;
+
+            /**
+             * The bpm of the last tempo event visited, or 0 if there was none.
+             */
+            uint16_t tempo = 0;
+
+            /**
+             * Contents of the variable memory of the traversal at the time of
+             * the snapshot. Empty if the traversal was given no memory.
+             */
+            std::vector<int16_t> variables;
+        };
+
+        /**
+         * Variable memory of size slots, which events executed during a
+         * traversal read and write in place of types::variable::memory.
+         * Without data, traversal leaves types::variable::memory in use and
+         * checkpoints capture no variables.
+         */
+        struct variable_memory
+        {
+            int16_t* data;
+            size_t   size;
+        };
+
+        /**
+         * Checkpoints ordered by tick.
+         */
+        using checkpoint_table = std::vector<checkpoint>;
+
+        /**
+         * Maps track numbers to the first event of each track.
+         */
+        using track_map = std::map<size_t, event_const_iterator>;
+
+        /**
+         * How traverse_tracks runs the tracks of a sequence.
+         */
+        enum class track_execution
+        {
+            /**
+             * Each track runs to completion independently of the others,
+             * spread over worker threads. Suited for offline analysis.
+             *
+             * Tracks never use types::variable::memory in this mode, as they
+             * would race on it; they use the memory given for each track, if
+             * any.
+             */
+            parallel,
+
+            /**
+             * Tracks advance together tick by tick on the calling thread, in
+             * ascending track number within a tick, as they do in playback.
+             */
+            interleaved,
+        };
+
+        /**
+         * How make_sequence decodes the events in the DATA section.
+         */
+        enum class decoding
+        {
+            /**
+             * Events are decoded from the stream one after another.
+             */
+            serial,
+
+            /**
+             * The DATA section is read into memory and split at the labelled
+             * offsets from the LABL section. The pieces are decoded
+             * concurrently, then joined, and references between them are
+             * resolved afterwards. Yields the same sequence as serial.
+             */
+            parallel,
+        };
+
+        static sequence make_sequence(std::istream&, decoding = decoding::serial);
         void traverse(visitor&) const;
 
+        /**
+         * Resumes traversal from the given checkpoint. Restores the given
+         * variable memory from the checkpoint before the first event is
+         * visited.
+         */
+        void traverse(visitor&, const checkpoint&, variable_memory = {}) const;
+
+        /**
+         * Traverses the sequence with the given visitor, taking a checkpoint
+         * at the start and then at the first event boundary past every
+         * tick_interval ticks. Each checkpoint holds a copy of the given
+         * variable memory.
+         *
+         * @param tick_interval Must not be 0.
+         */
+        checkpoint_table make_checkpoints(visitor&, uint32_t tick_interval, variable_memory = {}) const;
+
+        /**
+         * Restores the last checkpoint in the table at or before the given
+         * tick, then traverses with the given visitor until the tick is
+         * reached. The cost of seeking is thus bounded by the checkpoint
+         * interval, regardless of the position sought to.
+         *
+         * @param fast_forward Visits the events between the restored check-
+         *                     point and the tick. Should make the same control
+         *                     flow decisions as the visitor that recorded the
+         *                     checkpoints.
+         *
+         * @param variables    Restored from the checkpoint, and then updated
+         *                     by the events visited.
+         *
+         * @return Checkpoint at the first event boundary at or past the tick,
+         *         to be passed to traverse to continue from there.
+         */
+        checkpoint seek(const checkpoint_table&, visitor& fast_forward, uint32_t tick,
+                        variable_memory variables = {}) const;
+
+        /**
+         * Discovers the tracks of this sequence. Track 0 starts at the first
+         * event; other tracks start where the first open_track event for the
+         * track number points to, unless the last track_usage event before
+         * it marks the track as unused.
+         */
+        track_map tracks() const;
+
+        /**
+         * Traverses each track discovered by tracks() with its own control
+         * flow, that is, its own call and loop stacks and tick count.
+         *
+         * @param visitor_of Returns the visitor for the given track number.
+         *                   Called on the calling thread once per track, in
+         *                   ascending track number, before any event is
+         *                   visited. Visitors of different tracks must be
+         *                   distinct objects, so per-track results can be
+         *                   merged in track order afterwards.
+         *
+         * @param memory_of  Returns the variable memory for the given track
+         *                   number, called along with visitor_of. Tracks run
+         *                   in parallel must be given memory that does not
+         *                   overlap. If empty, interleaved tracks use
+         *                   types::variable::memory and parallel tracks run
+         *                   without variable memory.
+         */
+        void traverse_tracks(const std::function<visitor&(size_t track_no)>& visitor_of,
+                             track_execution,
+                             const std::function<variable_memory(size_t track_no)>& memory_of = nullptr) const;
+
+        /**
+         * Visits every event exactly once in storage order, without following
+         * control flow. The events are split into contiguous chunks that are
+         * visited concurrently, each by a visitor of its own.
+         *
+         * Operations passed to the visitors have no effect.
+         *
+         * @param make_visitor Returns a new visitor by value. Called on the
+         *                     calling thread once per chunk, before any event
+         *                     is visited.
+         *
+         * @param reduce       Called as reduce(result, chunk_visitor) on the
+         *                     calling thread, once for the visitor of each
+         *                     chunk after the first, in storage order.
+         *
+         * @return The visitor of the first chunk, with the visitors of the
+         *         other chunks reduced into it.
+         */
+        template<typename VisitorFactory, typename Reduce>
+        auto parallel_for_each_event(VisitorFactory make_visitor, Reduce reduce) const
+        {
+            const auto bounds = partition_events();
+
+            std::vector<decltype(make_visitor())> visitors;
+            visitors.reserve(bounds.size());
+            do
+            {
+                visitors.push_back(make_visitor());
+            } while (visitors.size() + 1 < bounds.size());
+
+            for_each_event(bounds, [&visitors](const size_t chunk) -> visitor&
+                                   {   return visitors[chunk]; });
+
+            for (size_t chunk = 1; chunk < visitors.size(); ++chunk)
+            {
+                reduce(visitors.front(), visitors[chunk]);
+            }
+            return std::move(visitors.front());
+        }
+
     private:
         using label_event_map = std::unordered_map<std::string, event_const_iterator>;
 
+        /**
+         * Checkpoint before the first event of this sequence.
+         */
+        checkpoint initial_checkpoint() const;
+
+        /**
+         * Splits the events into contiguous chunks for parallel_for_each_event.
+         *
+         * @return The first event of every chunk, followed by the end of the
+         *         events. Contains only the end if there are no events.
+         */
+        std::vector<event_const_iterator> partition_events() const;
+
+        /**
+         * Visits the events of every chunk delimited by bounds concurrently,
+         * chunk i with visitor_of(i).
+         */
+        void for_each_event(const std::vector<event_const_iterator>& bounds,
+                            const std::function<visitor&(size_t chunk)>& visitor_of) const;
+
         event_container _m_events;
         label_event_map _m_label_2_event;
     };
@@ -0,0 +1,145 @@
+#ifndef BRTOOLS_DATA_STREAM_PLAYER_H
+#define BRTOOLS_DATA_STREAM_PLAYER_H
+#pragma once
+
+#include <atomic>
+#include <chrono>       // for milliseconds
+#include <condition_variable>
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int16_t, uint64_t
+#include <exception>    // for exception_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <brtools/data/stream/stream.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace stream
+{
+    /**
+     * Plays a stream for an audio callback. A background thread decodes the
+     * stream ahead of the callback into a ring of slices, which the callback
+     * copies out of without locking, allocating or waiting.
+     *
+     * The ring has a single producer, the background thread, and a single
+     * consumer, the thread calling read. Slices the consumer is done with
+     * are released by the producer, so that the consumer never frees memory.
+     */
+    class player
+    {
+    public:
+        struct buffering
+        {
+            /**
+             * The most frames decoded ahead of the consumer.
+             */
+            size_t read_ahead_frames = 16384;
+
+            /**
+             * The most frames in a slice. Slices also end at the end of a
+             * block, and at the end of the stream.
+             */
+            size_t slice_frames = 1024;
+
+            /**
+             * How long the decoding thread sleeps when it is read_ahead_frames
+             * ahead, which bounds how late it refills the ring.
+             */
+            std::chrono::milliseconds refill_interval{ 5 };
+        };
+
+        /**
+         * Starts decoding at the given sample. Looping streams play on
+         * forever, restarting at the loop start, unless looping is disabled.
+         * The stream must outlive the player.
+         *
+         * @throws std::out_of_range if the sample is past the end of the stream.
+         */
+        player(const stream&, const buffering&, size_t first_sample = 0, bool looping = true);
+        player(const stream&);
+        player(const player&) = delete;
+        player& operator=(const player&) = delete;
+
+        /**
+         * Stops the decoding thread.
+         */
+        ~player();
+
+        /**
+         * Copies up to frame_count frames into the given channels, one
+         * buffer per channel of the stream, and fills the rest with silence.
+         * Wait-free; may be called from one thread only.
+         *
+         * Counts an underrun if fewer frames were buffered than requested,
+         * unless the stream has finished.
+         *
+         * @return The number of frames copied from the stream.
+         */
+        size_t read(int16_t* const* channels, size_t frame_count);
+
+        /**
+         * Whether every frame of a stream that does not loop has been read,
+         * or decoding failed.
+         */
+        bool finished() const;
+
+        /**
+         * The exception that stopped decoding, if any. Meaningful once
+         * finished.
+         */
+        std::exception_ptr error() const;
+
+        /**
+         * The number of reads that found fewer frames buffered than they
+         * asked for.
+         */
+        uint64_t underruns() const;
+
+        /**
+         * The number of frames decoded but not read yet.
+         */
+        size_t fill_level() const;
+
+    private:
+        void decode_ahead();
+
+        const stream&   _m_stream;
+        const buffering _m_buffering;
+        const bool      _m_looping;
+        stream::cursor  _m_cursor;
+
+        /**
+         * The ring of slices. Slots from _m_read_index up to _m_write_index
+         * belong to the consumer; the others to the producer. Indices only
+         * grow, and are taken modulo the number of slots.
+         */
+        std::vector<pcm16_audio_data> _m_slots;
+        std::atomic<size_t>           _m_read_index{ 0 };
+        std::atomic<size_t>           _m_write_index{ 0 };
+
+        /**
+         * Frames of the slot at _m_read_index already read. Consumer only.
+         */
+        size_t                        _m_read_offset = 0;
+
+        std::atomic<size_t>           _m_buffered_frames{ 0 };
+        std::atomic<uint64_t>         _m_underruns{ 0 };
+
+        /**
+         * Set by the producer once it has written the last slice.
+         */
+        std::atomic<bool>             _m_decoded_all{ false };
+        std::exception_ptr            _m_error;
+
+        std::mutex                    _m_mutex;
+        std::condition_variable       _m_stop_requested;
+        bool                          _m_stopping = false;
+        std::thread                   _m_thread;
+    };
+}
+}
+}
+#endif
@@ -0,0 +1,206 @@
+#ifndef BRTOOLS_DATA_STREAM_STREAM_H
+#define BRTOOLS_DATA_STREAM_STREAM_H
+#pragma once
+
+#include <memory>   // for unique_ptr
+#include <iosfwd>   // for forward-declaration of istream
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t
+#include <cstddef>  // for size_t
+#include <vector>
+#include <brtools/data/audio_data.h>
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/data/encoding.h>
+#include <brtools/data/playable.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace stream
+{
+    /**
+     * Represents streamed audio from an RSTM file, typically background music.
+     *
+     * The samples are divided into blocks of a fixed number of samples, and
+     * each block stores the samples of every channel one channel after
+     * another. DSP-ADPCM streams record the history at the start of every
+     * block, so that each block of each channel can be decoded on its own.
+     */
+    class stream : public playable
+    {
+    public:
+        /**
+         * How decode spreads the blocks of the stream.
+         */
+        enum class decoding
+        {
+            /**
+             * Blocks are decoded one after another on the calling thread.
+             */
+            serial,
+
+            /**
+             * Every block of every channel is decoded concurrently, spread
+             * over worker threads. Yields the same samples as serial.
+             */
+            parallel,
+        };
+
+        /**
+         * Reads the stream information and the sample data of every block
+         * into memory.
+         *
+         * @throws error::integrity_error if the file is not a well-formed RSTM.
+         */
+        static stream make_stream(std::istream&);
+
+        encoding stream_encoding() const;
+        size_t   channel_count() const;
+        uint16_t sample_rate() const;
+
+        /**
+         * The number of samples in each channel.
+         */
+        size_t sample_count() const;
+
+        bool loops() const;
+
+        /**
+         * The sample playback returns to after the last one, if the stream
+         * loops.
+         */
+        size_t loop_start() const;
+
+        size_t block_count() const;
+
+        /**
+         * The number of samples in each block but the last, which may hold
+         * fewer.
+         */
+        size_t block_samples() const;
+
+        /**
+         * The coefficients of the given channel. Meaningful only for
+         * DSP-ADPCM streams.
+         */
+        const dsp_adpcm::coefficients& coefficients(size_t channel) const;
+
+        /**
+         * Decodes every sample of every channel.
+         */
+        pcm16_audio_data decode(decoding = decoding::serial) const;
+
+        /**
+         * Reads the samples of a stream in order from any position, decoding
+         * a block of every channel at a time.
+         *
+         * Seeking restores the history at the start of the block containing
+         * the position, as recorded in the ADPC section, so it costs at most
+         * the decoding of that block regardless of where the position is.
+         */
+        class cursor
+        {
+        public:
+            /**
+             * Starts at the first sample. The stream must outlive the cursor.
+             */
+            explicit cursor(const stream&);
+
+            /**
+             * Moves to the given sample. The block containing it is decoded
+             * on the next read, unless it is the block decoded last.
+             *
+             * @throws std::out_of_range if the sample is past sample_count.
+             */
+            void seek(size_t sample);
+
+            /**
+             * The sample to be read next.
+             */
+            size_t tell() const;
+
+            /**
+             * Reads up to count samples of every channel and advances past
+             * them. Stops at the end of the decoded block, so fewer samples
+             * may be read; none are read only at the end of the stream.
+             *
+             * The samples returned share the decoded block, which is not
+             * written to again once the cursor moves past it.
+             */
+            pcm16_audio_data read(size_t count);
+
+            /**
+             * Same as read, except that at the end of a looping stream the
+             * cursor seeks to the loop start and continues from there.
+             */
+            pcm16_audio_data read_looping(size_t count);
+
+        private:
+            const stream*    _m_stream;
+            size_t           _m_position;
+
+            /**
+             * The block decoded last, which _m_decoded holds.
+             */
+            size_t           _m_block;
+            pcm16_audio_data _m_decoded;
+        };
+
+    private:
+        stream() = default;
+
+        /**
+         * Decodes the given block of the given channel into samples, which
+         * must have room for the samples of the block.
+         *
+         * @throws error::integrity_error if the block is malformed.
+         */
+        void decode_block(size_t block, size_t channel, int16_t* samples) const;
+
+        /**
+         * Decodes the given block of every channel.
+         */
+        pcm16_audio_data decode_block(size_t block) const;
+
+        /**
+         * The history at the start of the given block of the given channel.
+         */
+        dsp_adpcm::history block_history(size_t block, size_t channel) const;
+
+        /**
+         * The samples of the given block of the given channel, as stored.
+         */
+        const char* block_data(size_t block, size_t channel) const;
+
+        size_t samples_in_block(size_t block) const;
+
+        encoding _m_encoding         = encoding::adpcm;
+        bool     _m_loops            = false;
+        size_t   _m_channel_count    = 0;
+        uint16_t _m_sample_rate      = 0;
+        size_t   _m_loop_start       = 0;
+        size_t   _m_sample_count     = 0;
+        size_t   _m_block_count      = 0;
+        size_t   _m_block_size       = 0;
+        size_t   _m_block_samples    = 0;
+        size_t   _m_last_block_size  = 0;
+
+        /**
+         * Whether 16-bit samples are stored in the reverse byte order of the
+         * machine.
+         */
+        bool     _m_byte_order_reversed = false;
+
+        std::vector<dsp_adpcm::coefficients> _m_coefficients;
+
+        /**
+         * The history at the start of every block, by block then channel.
+         */
+        std::vector<dsp_adpcm::history> _m_block_histories;
+
+        std::unique_ptr<const char[]> _m_data;
+    };
+}
+}
+}
+#endif
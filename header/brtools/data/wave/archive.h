@@ -0,0 +1,63 @@
+#ifndef BRTOOLS_DATA_WAVE_ARCHIVE_H
+#define BRTOOLS_DATA_WAVE_ARCHIVE_H
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <vector>
+#include <brtools/data/wave/wave.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace wave
+{
+    /**
+     * Represents an RWAR wave archive, the waves a sound bank plays.
+     *
+     * Only the table of the archive is read up front, so that loading an
+     * archive costs the same however many waves it holds; the header of a
+     * wave is read when the wave is asked for. Nothing is copied: the
+     * archive refers to its waves within the bytes it was made from, which
+     * are typically mapped from a file and must outlive the archive and its
+     * waves.
+     */
+    class archive
+    {
+    public:
+        /**
+         * Reads the table of the RWAR file in the given bytes.
+         *
+         * @throws error::integrity_error if the bytes are not a well-formed
+         *                                RWAR, or a wave lies outside them.
+         */
+        static archive make_archive(const char* data, size_t size);
+
+        /**
+         * The number of waves in the archive.
+         */
+        size_t size() const;
+
+        /**
+         * Reads the header of the wave at the given index.
+         *
+         * @throws std::out_of_range if the index is not below size.
+         * @throws error::integrity_error if the wave is not a well-formed RWAV.
+         */
+        wave at(size_t index) const;
+
+    private:
+        archive() = default;
+
+        struct entry
+        {
+            const char* data;
+            size_t      size;
+        };
+
+        std::vector<entry> _m_entries;
+    };
+}
+}
+}
+#endif
@@ -0,0 +1,107 @@
+#ifndef BRTOOLS_DATA_WAVE_WAVE_H
+#define BRTOOLS_DATA_WAVE_WAVE_H
+#pragma once
+
+#include <cstdint>  // for uint32_t
+#include <cstddef>  // for size_t
+#include <vector>
+#include <brtools/data/audio_data.h>
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/data/encoding.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace wave
+{
+    /**
+     * Represents a wave from an RWAV file, on its own or within a wave
+     * archive. The samples are not copied: the wave refers to them within
+     * the bytes it was made from, which must outlive it.
+     */
+    class wave
+    {
+    public:
+        struct channel
+        {
+            /**
+             * The samples of the channel as stored, sample_bytes long.
+             */
+            const char* samples;
+
+            /**
+             * Meaningful only for DSP-ADPCM waves, as are the histories.
+             */
+            dsp_adpcm::coefficients coefs;
+
+            /**
+             * The history before the first sample.
+             */
+            dsp_adpcm::history hist;
+
+            /**
+             * The history before the loop start.
+             */
+            dsp_adpcm::history loop_hist;
+        };
+
+        /**
+         * Reads the header of the RWAV file in the given bytes.
+         *
+         * @throws error::integrity_error if the bytes are not a well-formed
+         *                                RWAV, or its samples lie outside them.
+         */
+        static wave make_wave(const char* data, size_t size);
+
+        encoding wave_encoding() const;
+        uint32_t sample_rate() const;
+        size_t   channel_count() const;
+
+        /**
+         * The number of samples in each channel, up to the end of the loop
+         * if the wave loops.
+         */
+        size_t sample_count() const;
+
+        bool loops() const;
+
+        /**
+         * The sample playback returns to after the last one, if the wave
+         * loops.
+         */
+        size_t loop_start() const;
+
+        const channel& channel_at(size_t index) const;
+
+        /**
+         * The bytes the samples of each channel take.
+         */
+        size_t sample_bytes() const;
+
+        /**
+         * Decodes every sample of every channel.
+         */
+        pcm16_audio_data decode() const;
+
+    private:
+        wave() = default;
+
+        encoding _m_encoding    = encoding::adpcm;
+        bool     _m_loops       = false;
+        uint32_t _m_sample_rate = 0;
+        size_t   _m_loop_start  = 0;
+        size_t   _m_sample_count = 0;
+
+        /**
+         * Whether 16-bit samples are stored in the reverse byte order of the
+         * machine.
+         */
+        bool     _m_byte_order_reversed = false;
+
+        std::vector<channel> _m_channels;
+    };
+}
+}
+}
+#endif
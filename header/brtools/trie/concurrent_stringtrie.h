@@ -0,0 +1,197 @@
+#ifndef BRTOOLS_TRIE_CONCURRENT_STRINGTRIE_H
+#define BRTOOLS_TRIE_CONCURRENT_STRINGTRIE_H
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdint>      // uint64_t
+#include <cstddef>      // size_t
+#include <vector>
+
+#include <brtools/trie/stringtrie.h>
+#include <brtools/util/string_ref.h>
+
+namespace brtools
+{
+namespace trie
+{
+    /**
+     * A trie of strings shared by threads that look strings up while others
+     * insert new ones.
+     *
+     * Every insertion builds a new version of the trie. The branches on the
+     * path to the new leaf are copied, the rest is shared with the previous
+     * version, and the new version is published by swapping a pointer, so
+     * that a version never changes once it can be read. Readers look strings
+     * up in a snapshot of the current version, taken without locking or
+     * waiting on writers. The branches replaced by a writer are freed once no
+     * snapshot that could see them remains.
+     *
+     * Strings are never removed, so ids and strings stay valid for the
+     * lifetime of the trie.
+     */
+    class concurrent_stringtrie
+    {
+    public:
+        using string_id_type = stringtrie::string_id_type;
+        enum : string_id_type
+        { invalid = stringtrie::invalid };
+
+        class reader;
+        class snapshot;
+
+    private:
+        struct node;
+        struct leaf;
+        struct version;
+        struct reader_slot;
+        struct retired;
+
+    public:
+        concurrent_stringtrie();
+
+        /**
+         * All readers must have been destroyed.
+         */
+        ~concurrent_stringtrie();
+
+        concurrent_stringtrie(const concurrent_stringtrie&) = delete;
+        concurrent_stringtrie& operator=(const concurrent_stringtrie&) = delete;
+
+    public:
+        /**
+         * Inserts a string into this trie, or retrieves the id of the string
+         * if it is already there. Insertions are serialized with each other,
+         * but do not wait on readers. The string is in every snapshot taken
+         * after this returns.
+         *
+         * @return The id associated with the string.
+         *
+         * @throws std::length_error if the string is longer than 512 MiB, or
+         *                           there are too many strings.
+         */
+        string_id_type insert(util::string_ref);
+
+    private:
+        const leaf* leaf_at(string_id_type) const;
+        void reclaim();
+
+    private:
+        /**
+         * Ids are located in segments twice as large as the one before, which
+         * are never moved once allocated.
+         */
+        static constexpr size_t first_segment_size = 64;
+        static constexpr size_t segment_count      = 32;
+
+        std::atomic<const version*>       _m_version;
+        std::atomic<uint64_t>             _m_epoch;
+        mutable std::atomic<reader_slot*> _m_readers;
+
+        /**
+         * The state below belongs to writers, and is guarded by the mutex.
+         * Segments and leaves are written before the version that refers to
+         * them is published, so readers see them complete.
+         */
+        std::mutex                        _m_writer_mutex;
+        const leaf**                      _m_segments[segment_count];
+        std::vector<retired>              _m_retired;
+    };
+
+    /**
+     * Takes snapshots of a concurrent_stringtrie for one thread. A reader is
+     * meant to be kept by its thread, since creating one registers it with
+     * the trie; taking a snapshot afterwards does not allocate, lock or
+     * wait.
+     */
+    class concurrent_stringtrie::reader
+    {
+    public:
+        explicit reader(const concurrent_stringtrie&);
+
+        /**
+         * Snapshots taken by the reader must have been destroyed.
+         */
+        ~reader();
+
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+
+    public:
+        /**
+         * Takes a snapshot of the current version of the trie. The branches
+         * it sees are kept until it is destroyed, so snapshots are meant to
+         * be short-lived.
+         */
+        snapshot take_snapshot() const;
+
+        /**
+         * Retrieves the id of the given string in the current version of the
+         * trie, or the invalid id if the string is not in the trie.
+         */
+        string_id_type find_id(util::string_ref) const;
+
+    private:
+        const concurrent_stringtrie& _m_trie;
+        reader_slot&                 _m_slot;
+    };
+
+    /**
+     * A version of a concurrent_stringtrie, unaffected by later insertions.
+     */
+    class concurrent_stringtrie::snapshot
+    {
+        friend class concurrent_stringtrie::reader;
+
+    public:
+        snapshot(snapshot&&) noexcept;
+        ~snapshot();
+
+        snapshot(const snapshot&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+        snapshot& operator=(snapshot&&) = delete;
+
+    public:
+        /**
+         * Retrieves the id of the given string, or the invalid id if the
+         * string is not in this version.
+         *
+         * Does not allocate memory.
+         */
+        string_id_type find_id(util::string_ref) const;
+
+        /**
+         * Retrieves the string associated with the given id without copying
+         * it. The reference is valid for the lifetime of the trie.
+         *
+         * @throws std::out_of_range if the id is not associated with any
+         *                           string in this version.
+         * @throws std::invalid_argument if the given id is an invalid id.
+         */
+        util::string_ref find_string_ref(string_id_type) const;
+
+        /**
+         * Retrieves the string associated with the given id.
+         *
+         * @see find_string_ref
+         */
+        std::string find_string(string_id_type) const;
+
+        /**
+         * The number of strings in this version.
+         */
+        size_t size() const;
+
+    private:
+        snapshot(const concurrent_stringtrie&, reader_slot&);
+
+    private:
+        const concurrent_stringtrie* _m_trie;
+        reader_slot*                 _m_slot;
+        const version*               _m_version;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef BRTOOLS_TRIE_FROZEN_STRINGTRIE_H
+#define BRTOOLS_TRIE_FROZEN_STRINGTRIE_H
+#pragma once
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <string>
+#include <vector>
+
+#include <brtools/trie/stringtrie.h>
+#include <brtools/util/string_ref.h>
+
+namespace brtools
+{
+namespace trie
+{
+    /**
+     * Read-only, compact form of a stringtrie, for very large sets of strings.
+     *
+     * The shape of the trie is kept as one bit per node in level order, with
+     * a rank directory to find the children of a node; bit indices and ids
+     * are bit-packed to the width their largest value needs. Strings are
+     * front-coded in sorted order, in buckets of 16.
+     *
+     * Everything lives in a single buffer, which can be written to a file as
+     * is and mapped back into memory later. The buffer is in the byte order
+     * of the machine that built it.
+     */
+    class frozen_stringtrie
+    {
+    public:
+        using string_id_type = stringtrie::string_id_type;
+
+        enum : string_id_type
+        { invalid = stringtrie::invalid };
+
+    public:
+        /**
+         * Freezes the given trie. The strings keep their ids.
+         */
+        explicit frozen_stringtrie(const stringtrie&);
+
+        /**
+         * Uses the buffer of a frozen trie, such as a mapped file, without
+         * copying it. The buffer must outlive this object.
+         *
+         * @param data Must be aligned to 8 bytes.
+         *
+         * @throws error::integrity_error if the buffer is not a frozen trie
+         *                                built on a machine of the same byte
+         *                                order, or is truncated or corrupt.
+         * @throws std::invalid_argument if data is not aligned.
+         */
+        frozen_stringtrie(const char* data, size_t size);
+
+        frozen_stringtrie(const frozen_stringtrie&) = delete;
+        frozen_stringtrie(frozen_stringtrie&&) = default;
+        frozen_stringtrie& operator=(frozen_stringtrie&&) = default;
+
+    public:
+        /**
+         * Retrieves the id of the given string. If the string is not in the
+         * trie, the invalid id is returned.
+         *
+         * Does not allocate memory.
+         */
+        string_id_type find_id(util::string_ref) const;
+
+        /**
+         * Retrieves the string associated with the given id. Strings are
+         * compressed, so they can only be returned by value.
+         *
+         * @throws std::out_of_range if the id is not associated with any
+         *                           string in the trie.
+         * @throws std::invalid_argument if the given id is an invalid id.
+         */
+        std::string find_string(string_id_type) const;
+
+        /**
+         * The number of strings in the trie.
+         */
+        size_t size() const;
+
+        /**
+         * The buffer, to be written to a file.
+         */
+        const char* data() const;
+        size_t data_size() const;
+
+        /**
+         * The size of the buffer divided by the number of strings, including
+         * the characters of the strings.
+         */
+        double bytes_per_key() const;
+
+    private:
+        struct header;
+
+        const header& get_header() const;
+        const uint64_t* section(uint64_t offset) const;
+
+        /**
+         * Checks that the walk down the trie and the decoding of strings stay
+         * within the buffer, which could be corrupt.
+         *
+         * @throws error::integrity_error if they would not.
+         */
+        void check_topology() const;
+        void check_strings() const;
+
+        bool is_branch(size_t node) const;
+        size_t rank_of_branches(size_t node) const;
+
+        /**
+         * The position of the string in sorted order, or size() if there is
+         * no string under the id.
+         */
+        size_t sorted_rank(string_id_type) const;
+
+        /**
+         * Whether the string at the given position in sorted order equals
+         * str, compared while decoding, without building the string.
+         */
+        bool sorted_string_equals(size_t rank, util::string_ref str) const;
+
+    private:
+        /**
+         * Owned buffer, if the trie was frozen by this object. Words keep the
+         * buffer aligned.
+         */
+        std::vector<uint64_t> _m_storage;
+
+        const char* _m_data;
+        size_t      _m_size;
+    };
+}
+}
+
+#endif
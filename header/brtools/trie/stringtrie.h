@@ -2,34 +2,40 @@
 #define BRTOOLS_TRIE_STRINGTRIE_H
 #pragma once
 
-#include <unordered_map>
 #include <memory>       // std::unique_ptr
 #include <string>
 #include <cstdint>      // uint32_t
+#include <cstddef>      // size_t
 #include <initializer_list>
+#include <functional>   // std::function
+#include <vector>
 
 #include <brtools/util/id_dispenser.h>
+#include <brtools/util/string_ref.h>
 
 namespace brtools
 {
     namespace io
-    {
-    namespace detail
     {
         class stream_parser;
-    }
+        class stream_writer;
     }
 
     namespace trie
     {
         namespace detail
         {
-            struct trie_node;
+            class trie_node_pool;
+            class string_pool;
         }
 
+        class frozen_stringtrie;
+
         class stringtrie
         {
-            friend io::detail::stream_parser& operator>>(io::detail::stream_parser&, stringtrie&);
+            friend class frozen_stringtrie;
+            friend io::stream_parser& operator>>(io::stream_parser&, stringtrie&);
+            friend io::stream_writer& operator<<(io::stream_writer&, const stringtrie&);
 
         public:
             using string_id_type = uint32_t;
@@ -44,6 +50,34 @@ namespace brtools
              */
             stringtrie(const std::initializer_list<std::string>&);
 
+            /**
+             * Order of the strings given to the bulk constructor.
+             */
+            enum class key_order
+            {
+                unsorted,
+
+                /**
+                 * Sorted lexicographically, comparing characters as unsigned
+                 * char, which is the order of util::string_ref. Saves sorting.
+                 */
+                sorted,
+            };
+
+            /**
+             * Initializes a trie with the given strings at once. The sorted
+             * strings are joined into the trie in a single pass, without
+             * walking from the root for each string as insert does.
+             *
+             * Ids are associated in the order of the given strings, as if they
+             * were inserted one by one; repeated strings get the id of their
+             * first occurrence.
+             *
+             * @throws std::length_error if a string is longer than 512 MiB,
+             *                           or there are too many strings.
+             */
+            explicit stringtrie(const std::vector<util::string_ref>&, key_order = key_order::unsorted);
+
         public:
             /**
              * Inserts a string into this trie. If the string already exists in
@@ -51,15 +85,78 @@ namespace brtools
              * returned, and no new string will be inserted.
              *
              * @return The id associated with the string.
+             *
+             * @throws std::length_error if the string is longer than
+             *                           512 MiB, or there are too many
+             *                           strings.
              */
             string_id_type insert(std::string);
 
+            /**
+             * Erases a string from this trie. Its id is freed, and may be
+             * associated with a string inserted later.
+             *
+             * @return The id that was associated with the string, or the
+             *         invalid id if the string is not in the trie.
+             */
+            string_id_type erase(util::string_ref);
+
             /**
              * Retrieves the id of the given string. If the string is not in
              * the trie, the invalid id is returned.
              */
             string_id_type find_id(const std::string&) const;
 
+            /**
+             * Retrieves the id of the string made of the length characters
+             * starting at str, which need not be NUL-terminated. If the string
+             * is not in the trie, the invalid id is returned.
+             *
+             * Does not allocate memory.
+             */
+            string_id_type find_id(const char* str, size_t length) const;
+
+            /**
+             * Retrieves the ids of count strings at once, storing the id of
+             * keys[i] in ids[i], or the invalid id if it is not in the trie.
+             *
+             * Lookups are advanced in groups, one node each in turn, and the
+             * next node of each is prefetched, so that the cache misses of a
+             * group overlap instead of following one another.
+             *
+             * Does not allocate memory.
+             */
+            void find_ids(const util::string_ref* keys, size_t count, string_id_type* ids) const;
+
+            /**
+             * Retrieves the ids of the given strings at once.
+             *
+             * @see find_ids(const util::string_ref*, size_t, string_id_type*)
+             */
+            std::vector<string_id_type> find_ids(const std::vector<util::string_ref>& keys) const;
+
+            /**
+             * Visits the strings starting with the given prefix in
+             * lexicographic order, which is the order of their bits. The
+             * strings are not copied.
+             *
+             * @param visitor Called with the id and string of each string
+             *                until it returns false. Must not modify the
+             *                trie.
+             *
+             * @return false if the visitor stopped the enumeration, true
+             *         otherwise.
+             */
+            bool for_each_with_prefix(util::string_ref prefix,
+                                      const std::function<bool(string_id_type, util::string_ref)>& visitor) const;
+
+            /**
+             * Visits all strings in lexicographic order.
+             *
+             * @see for_each_with_prefix
+             */
+            bool for_each(const std::function<bool(string_id_type, util::string_ref)>& visitor) const;
+
             /**
              * Retrieves the string associated with the given id.
              *
@@ -69,11 +166,49 @@ namespace brtools
              */
             std::string find_string(string_id_type) const;
 
+            /**
+             * Retrieves the string associated with the given id without
+             * copying it. The reference is valid until the next insertion or
+             * erasure.
+             *
+             * @throws std::out_of_range if the id is not associated with any
+             *                           string in the trie.
+             * @throws std::invalid_argument if the given id is an invalid id.
+             */
+            util::string_ref find_string_ref(string_id_type) const;
+
         private:
-            std::unique_ptr<detail::trie_node>              _m_root;
-            std::unordered_map<string_id_type, std::string> _m_strings;
+            std::unique_ptr<detail::trie_node_pool>         _m_nodes;
+            std::unique_ptr<detail::string_pool>            _m_strings;
             util::id_dispenser<string_id_type>              _m_id_dispenser;
         };
+
+        /**
+         * Reads a trie in the BR SYMB format, replacing the contents of the
+         * given trie. The data starts at the current position with
+         *
+         *     u32 offset to string table
+         *     u32 offset to Patricia tree
+         *
+         * which is how an RSAR SYMB block starts, after its section header,
+         * so this reads the first tree of an RSAR. Offsets are relative to
+         * the start, and are followed by the stream_parser. The strings of
+         * the tree keep their ids in the string table.
+         *
+         * The stream position is left where it was.
+         *
+         * @throws error::integrity_error if the tree is malformed.
+         */
+        io::stream_parser& operator>>(io::stream_parser&, stringtrie&);
+
+        /**
+         * Writes the trie in the BR SYMB format read by operator>>, with
+         * one tree whose item ids are the string ids.
+         *
+         * @throws std::length_error if strings differ past the bits the
+         *                           16-bit index of the format addresses.
+         */
+        io::stream_writer& operator<<(io::stream_writer&, const stringtrie&);
     }
 
 }
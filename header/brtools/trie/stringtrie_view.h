@@ -0,0 +1,99 @@
+#ifndef BRTOOLS_TRIE_STRINGTRIE_VIEW_H
+#define BRTOOLS_TRIE_STRINGTRIE_VIEW_H
+#pragma once
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t
+
+#include <brtools/trie/stringtrie.h>
+#include <brtools/util/string_ref.h>
+
+namespace brtools
+{
+namespace trie
+{
+    /**
+     * Read-only trie that answers lookups directly from the bytes of a BR
+     * SYMB block, in the format read by operator>>(io::stream_parser&,
+     * stringtrie&), without building any node. Opening a view only checks
+     * that the tree and string table lie within the bytes, so it takes
+     * constant time regardless of the number of strings.
+     *
+     * The bytes are expected to be big endian, as in BR files, and must
+     * outlive the view.
+     */
+    class stringtrie_view
+    {
+    public:
+        using string_id_type = stringtrie::string_id_type;
+        using item_id_type   = uint32_t;
+
+        enum : uint32_t
+        { invalid = stringtrie::invalid };
+
+    public:
+        /**
+         * @param data        The data of the SYMB block, following the section
+         *                    header.
+         * @param tree_number The tree to look up in. In RSAR files, 0 through
+         *                    3 are the trees of sounds, players, groups and
+         *                    banks, which share the string table.
+         *
+         * @throws error::integrity_error if the offsets point out of the data.
+         */
+        stringtrie_view(const char* data, size_t size, size_t tree_number = 0);
+
+    public:
+        /**
+         * Retrieves the string id of the given string, or the invalid id if
+         * the string is not in the tree.
+         *
+         * @throws error::integrity_error if the tree is malformed.
+         */
+        string_id_type find_id(util::string_ref) const;
+
+        /**
+         * Retrieves the item id associated with the given string, such as the
+         * sound number in an RSAR, or the invalid id if the string is not in
+         * the tree.
+         *
+         * @throws error::integrity_error if the tree is malformed.
+         */
+        item_id_type find_item_id(util::string_ref) const;
+
+        /**
+         * Retrieves the string associated with the given id, referring to the
+         * bytes of the view.
+         *
+         * @throws std::out_of_range if the id is not in the string table.
+         * @throws error::integrity_error if the string is not within the data.
+         */
+        util::string_ref find_string(string_id_type) const;
+
+    private:
+        /**
+         * Retrieves the offset of the node of the given string, or 0 if the
+         * string is not in the tree.
+         */
+        size_t find_leaf(util::string_ref) const;
+
+        /**
+         * Reads a big endian value at the given offset, checking the bounds.
+         */
+        uint32_t read_u32(size_t offset) const;
+        uint16_t read_u16(size_t offset) const;
+
+    private:
+        const char* _m_data;
+        size_t      _m_size;
+
+        uint32_t _m_string_table;
+        uint32_t _m_string_count;
+        size_t   _m_tree;
+        uint32_t _m_root;
+        uint32_t _m_node_count;
+    };
+}
+}
+
+#endif
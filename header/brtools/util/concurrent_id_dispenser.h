@@ -0,0 +1,194 @@
+#ifndef BRTOOLS_UTIL_CONCURRENT_ID_DISPENSER_H
+#define BRTOOLS_UTIL_CONCURRENT_ID_DISPENSER_H
+#pragma once
+
+#include <atomic>
+#include <cstdint>      // uint64_t
+#include <cstddef>      // size_t
+#include <memory>       // unique_ptr
+#include <stdexcept>    // length_error
+#include <vector>
+
+#include <brtools/util/id_dispenser.h>
+
+namespace brtools
+{
+namespace util
+{
+    /**
+     * Dispenses the ids from 0 to a capacity fixed at construction, to any
+     * number of threads at once, without locking.
+     *
+     * Free ids are tracked in a hierarchical bitmap like that of
+     * id_dispenser, allocated up front. The bits of the ids decide which
+     * ids are free; a thread claims an id by clearing its bit with a
+     * compare-and-swap. The bits of the levels above are hints, set if the
+     * word below may have a bit set, so that a thread only follows set
+     * bits down. A thread that finds a word empty clears its hint, and sets
+     * it again if the word was refilled meanwhile.
+     */
+    template<typename _IDType>
+    class concurrent_id_dispenser
+    {
+    public:
+        /**
+         * All ids below capacity start out free.
+         */
+        explicit concurrent_id_dispenser(const size_t capacity)
+        : _m_capacity(capacity)
+        {
+            auto bits = capacity;
+            do
+            {
+                const auto words = bits == 0 ? 1 : ((bits - 1) >> detail::bits_per_word_log2) + 1;
+                _m_levels.emplace_back(new std::atomic<uint64_t>[words]);
+
+                // sets the first bits bits of the level
+                for (size_t i = 0; i < words; ++i)
+                {
+                    const auto remaining = bits - i * detail::bits_per_word;
+                    _m_levels.back()[i].store(remaining >= detail::bits_per_word
+                                              ? ~uint64_t(0)
+                                              : (uint64_t(1) << remaining) - 1,
+                                              std::memory_order_relaxed);
+                }
+                bits = bits == 0 ? 0 : words;
+            }
+            while (bits > 1);
+        }
+
+        concurrent_id_dispenser(const concurrent_id_dispenser&) = delete;
+        concurrent_id_dispenser& operator=(const concurrent_id_dispenser&) = delete;
+
+        /**
+         * Claims the smallest free id that can be found.
+         *
+         * @throws std::length_error if all ids are in use.
+         */
+        _IDType dispense()
+        {
+            for (;;)
+            {
+                // follows the hints down from the top word
+                size_t index = 0;
+                auto level = _m_levels.size() - 1;
+                for (; level > 0; --level)
+                {
+                    const auto word = _m_levels[level][index].load();
+                    if (word == 0)
+                    {
+                        break;
+                    }
+                    index = (index << detail::bits_per_word_log2) + detail::count_trailing_zeros(word);
+                }
+
+                if (level > 0)
+                {
+                    if (level == _m_levels.size() - 1)
+                    {
+                        throw std::length_error("All ids are in use.");
+                    }
+                    // a stale hint led to an empty word
+                    clear_hint(level + 1, index);
+                    continue;
+                }
+
+                auto& word = _m_levels[0][index];
+                auto bits = word.load();
+                while (bits != 0)
+                {
+                    const auto bit = uint64_t(1) << detail::count_trailing_zeros(bits);
+                    if (word.compare_exchange_weak(bits, bits & ~bit))
+                    {
+                        if ((bits & ~bit) == 0)
+                        {
+                            clear_hint(1, index);
+                        }
+                        return static_cast<_IDType>((index << detail::bits_per_word_log2)
+                                                    + detail::count_trailing_zeros(bit));
+                    }
+                }
+                if (_m_levels.size() == 1)
+                {
+                    throw std::length_error("All ids are in use.");
+                }
+                clear_hint(1, index);
+            }
+        }
+
+        /**
+         * @param id Must have been dispensed, and not recycled since.
+         */
+        void recycle(const _IDType id)
+        {
+            size_t index = id;
+            for (auto& level : _m_levels)
+            {
+                const auto bit = uint64_t(1) << (index % detail::bits_per_word);
+                if (level[index >> detail::bits_per_word_log2].fetch_or(bit) != 0)
+                {
+                    // the hints above are set, or being set
+                    break;
+                }
+                index >>= detail::bits_per_word_log2;
+            }
+        }
+
+        size_t capacity() const
+        {
+            return _m_capacity;
+        }
+
+    private:
+        /**
+         * Clears the hint at the given level for the word with the given
+         * index in the level below, unless the word is refilled, and goes on
+         * up if that empties the word of the hint.
+         */
+        void clear_hint(size_t level, size_t index)
+        {
+            for (; level < _m_levels.size(); ++level, index >>= detail::bits_per_word_log2)
+            {
+                const auto bit = uint64_t(1) << (index % detail::bits_per_word);
+                auto& word = _m_levels[level][index >> detail::bits_per_word_log2];
+                const auto remaining = word.fetch_and(~bit) & ~bit;
+
+                // a recycle in between sets the word below before the hint,
+                // so either it sees the hint cleared and sets it, or the
+                // word is seen refilled here
+                if (_m_levels[level - 1][index].load() != 0)
+                {
+                    set_hints(level, index);
+                    return;
+                }
+                if (remaining != 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        void set_hints(size_t level, size_t index)
+        {
+            for (; level < _m_levels.size(); ++level, index >>= detail::bits_per_word_log2)
+            {
+                const auto bit = uint64_t(1) << (index % detail::bits_per_word);
+                if (_m_levels[level][index >> detail::bits_per_word_log2].fetch_or(bit) != 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    private:
+        size_t                                                _m_capacity;
+
+        /**
+         * Bits of the free ids, then the hints of each level below.
+         */
+        std::vector<std::unique_ptr<std::atomic<uint64_t>[]>> _m_levels;
+    };
+}
+}
+
+#endif
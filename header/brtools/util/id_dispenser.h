@@ -2,12 +2,52 @@
 #define BRTOOLS_UTIL_ID_DISPENSER_H
 #pragma once
 
-#include <forward_list>
+#include <cstdint>  // uint64_t
+#include <cstddef>  // size_t
+#include <vector>
 
 namespace brtools
 {
 namespace util
 {
+    namespace detail
+    {
+        constexpr size_t bits_per_word      = 64;
+        constexpr size_t bits_per_word_log2 = 6;
+
+        /**
+         * Index of the lowest 1 bit. Behavior is only defined if word is
+         * not 0.
+         */
+        inline size_t count_trailing_zeros(const uint64_t word)
+        {
+        #if defined(__GNUC__)
+            return static_cast<size_t>(__builtin_ctzll(word));
+        #else
+            size_t count = 0;
+            for (auto w = word; (w & 1) == 0; w >>= 1)
+            {
+                ++count;
+            }
+            return count;
+        #endif
+        }
+    }
+
+    /**
+     * Dispenses ids counting up from 0, reusing recycled ids first, smallest
+     * first.
+     *
+     * Recycled ids are tracked in a hierarchical bitmap: a bit per id below
+     * the next new id, and above that a bit per word of the level below,
+     * set if the word has any bit set, up to a single word. Finding the
+     * smallest recycled id takes one word per level, which is at most 6 for
+     * 32-bit ids. Recycling the largest id dispensed also drops the recycled
+     * ids right below it, so the bitmap only spans ids in use.
+     *
+     * The bitmap grows along with the ids dispensed, so recycle never
+     * allocates, and dispense only does when new ids reach another 64.
+     */
     template<typename _IDType>
     class id_dispenser
     {
@@ -16,33 +56,111 @@ namespace util
 
         _IDType dispense()
         {
-            if (_m_reuseable_ids.empty())
+            if (_m_levels.empty() || _m_levels.back()[0] == 0)
             {
+                reserve(_m_next_id);
                 return _m_next_id++;
             }
-            else
+
+            // follows the lowest set bit from the top word down
+            size_t index = 0;
+            for (auto level = _m_levels.size(); level-- > 0; )
             {
-                const auto id = _m_reuseable_ids.front();
-                _m_reuseable_ids.pop_front();
-                return id;
+                index = (index << detail::bits_per_word_log2)
+                      + detail::count_trailing_zeros(_m_levels[level][index]);
             }
+            clear(index);
+            return static_cast<_IDType>(index);
         }
 
+        /**
+         * @param id Must have been dispensed, and not recycled since.
+         */
         void recycle(const _IDType id)
         {
             if (id == _m_next_id - 1)
             {
                 _m_next_id = id;
+                while (_m_next_id > 0 && is_set(_m_next_id - 1))
+                {
+                    clear(--_m_next_id);
+                }
             }
             else
             {
-                _m_reuseable_ids.push_front(id);
+                set(id);
             }
         }
 
     private:
-        _IDType                    _m_next_id;
-        std::forward_list<_IDType> _m_reuseable_ids;
+        /**
+         * Grows the levels to span the given id.
+         */
+        void reserve(const size_t id)
+        {
+            auto words = (id >> detail::bits_per_word_log2) + 1;
+            for (size_t level = 0; ; ++level)
+            {
+                if (level == _m_levels.size())
+                {
+                    // the previous top word becomes the first word of a level
+                    // below a new top
+                    _m_levels.emplace_back(1, level > 0 && _m_levels[level - 1][0] != 0 ? 1 : 0);
+                }
+                if (_m_levels[level].size() < words)
+                {
+                    _m_levels[level].resize(words, 0);
+                }
+                if (words == 1 && level + 1 == _m_levels.size())
+                {
+                    break;
+                }
+                words = ((words - 1) >> detail::bits_per_word_log2) + 1;
+            }
+        }
+
+        bool is_set(const size_t index) const
+        {
+            return (_m_levels[0][index >> detail::bits_per_word_log2] >> (index % detail::bits_per_word)) & 1;
+        }
+
+        void set(size_t index)
+        {
+            for (auto& words : _m_levels)
+            {
+                auto& word = words[index >> detail::bits_per_word_log2];
+                const auto was_empty = word == 0;
+                word |= uint64_t(1) << (index % detail::bits_per_word);
+                if (!was_empty)
+                {
+                    break;
+                }
+                index >>= detail::bits_per_word_log2;
+            }
+        }
+
+        void clear(size_t index)
+        {
+            for (auto& words : _m_levels)
+            {
+                auto& word = words[index >> detail::bits_per_word_log2];
+                word &= ~(uint64_t(1) << (index % detail::bits_per_word));
+                if (word != 0)
+                {
+                    break;
+                }
+                index >>= detail::bits_per_word_log2;
+            }
+        }
+
+    private:
+        _IDType                            _m_next_id;
+
+        /**
+         * Bits of the recycled ids, then of the non-empty words of each
+         * level below.
+         */
+        std::vector<std::vector<uint64_t>> _m_levels;
     };
 }
 }
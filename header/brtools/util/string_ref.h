@@ -0,0 +1,96 @@
+#ifndef BRTOOLS_UTIL_STRING_REF_H
+#define BRTOOLS_UTIL_STRING_REF_H
+#pragma once
+
+#include <cstddef>  // size_t
+#include <cstring>  // strlen
+#include <string>
+
+namespace brtools
+{
+namespace util
+{
+    /**
+     * Non-owning reference to a range of characters.
+     */
+    // wait for C++17 and use std::string_view
+    class string_ref
+    {
+    public:
+        using const_iterator = const char*;
+
+    public:
+        constexpr string_ref() noexcept
+        : _m_data(nullptr), _m_length(0) {}
+
+        constexpr string_ref(const char* const data, const size_t length) noexcept
+        : _m_data(data), _m_length(length) {}
+
+        string_ref(const std::string& str) noexcept
+        : string_ref(str.data(), str.length()) {}
+
+        /**
+         * @param str Must be NUL-terminated.
+         */
+        string_ref(const char* const str)
+        : string_ref(str, std::strlen(str)) {}
+
+    public:
+        constexpr const char* data() const noexcept
+        {   return _m_data;   }
+
+        constexpr size_t length() const noexcept
+        {   return _m_length;   }
+
+        constexpr size_t size() const noexcept
+        {   return _m_length;   }
+
+        constexpr bool empty() const noexcept
+        {   return _m_length == 0;   }
+
+        constexpr const_iterator begin() const noexcept
+        {   return _m_data;   }
+
+        constexpr const_iterator end() const noexcept
+        {   return _m_data + _m_length;   }
+
+        constexpr char operator[](const size_t index) const
+        {   return _m_data[index];   }
+
+        /**
+         * Copies the referenced characters into a string.
+         */
+        std::string str() const
+        {   return std::string(_m_data, _m_length);   }
+
+        explicit operator std::string() const
+        {   return str();   }
+
+    public:
+        friend bool operator==(const string_ref lhs, const string_ref rhs) noexcept
+        {
+            return lhs._m_length == rhs._m_length &&
+                   std::char_traits<char>::compare(lhs._m_data, rhs._m_data, lhs._m_length) == 0;
+        }
+
+        friend bool operator!=(const string_ref lhs, const string_ref rhs) noexcept
+        {   return !(lhs == rhs);   }
+
+        /**
+         * Lexicographical order, comparing characters as unsigned char.
+         */
+        friend bool operator<(const string_ref lhs, const string_ref rhs) noexcept
+        {
+            const auto common = lhs._m_length < rhs._m_length ? lhs._m_length : rhs._m_length;
+            const auto result = std::char_traits<char>::compare(lhs._m_data, rhs._m_data, common);
+            return result < 0 || (result == 0 && lhs._m_length < rhs._m_length);
+        }
+
+    private:
+        const char* _m_data;
+        size_t      _m_length;
+    };
+}
+}
+
+#endif
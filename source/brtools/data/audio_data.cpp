@@ -0,0 +1,148 @@
+#include <brtools/data/audio_data.h>
+
+#include <cstdint>      // uintptr_t
+#include <mutex>
+#include <new>          // operator new, placement new
+#include <vector>
+
+using namespace brtools::data;
+using namespace brtools::data::detail;
+using namespace std;
+
+static_assert(sizeof(audio_block) <= audio_block_alignment, "The samples are expected to start one line past the block.");
+
+namespace
+{
+    constexpr size_t smallest_class_log2 = 12;   // 4 KiB
+    constexpr size_t largest_class_log2  = 20;   // small_audio_block_size
+
+    /**
+     * Blocks kept per size class, so that an idle pool holds a bounded
+     * amount of memory.
+     */
+    constexpr size_t blocks_per_class = 8;
+
+    static_assert(size_t(1) << largest_class_log2 == small_audio_block_size, "Size classes must cover small blocks.");
+
+    audio_block* allocate_block(const size_t capacity)
+    {
+        // room to align the block, and the line it takes before the samples
+        const auto allocation = ::operator new(capacity + 2 * audio_block_alignment);
+        const auto address = reinterpret_cast<uintptr_t>(allocation);
+        const auto aligned = (address + audio_block_alignment - 1) / audio_block_alignment * audio_block_alignment;
+
+        const auto block = new (reinterpret_cast<void*>(aligned)) audio_block;
+        block->capacity   = capacity;
+        block->allocation = allocation;
+        return block;
+    }
+
+    void free_block(audio_block* const block)
+    {
+        const auto allocation = block->allocation;
+        block->~audio_block();
+        ::operator delete(allocation);
+    }
+
+    /**
+     * Free small blocks by size class.
+     */
+    class block_pool
+    {
+    public:
+        ~block_pool()
+        {
+            for (auto& blocks : _m_classes)
+            {
+                for (const auto block : blocks)
+                {
+                    free_block(block);
+                }
+            }
+        }
+
+        audio_block* acquire(const size_t size_class)
+        {
+            const lock_guard<mutex> lock(_m_mutex);
+            auto& blocks = _m_classes[size_class];
+            if (blocks.empty())
+            {
+                return nullptr;
+            }
+            const auto block = blocks.back();
+            blocks.pop_back();
+            return block;
+        }
+
+        /**
+         * @return Whether the pool kept the block.
+         */
+        bool release(const size_t size_class, audio_block* const block)
+        {
+            const lock_guard<mutex> lock(_m_mutex);
+            auto& blocks = _m_classes[size_class];
+            if (blocks.size() == blocks_per_class)
+            {
+                return false;
+            }
+            if (blocks.capacity() == 0)
+            {
+                blocks.reserve(blocks_per_class);
+            }
+            blocks.push_back(block);
+            return true;
+        }
+
+    private:
+        mutex                _m_mutex;
+        vector<audio_block*> _m_classes[largest_class_log2 - smallest_class_log2 + 1];
+    };
+
+    block_pool& pool()
+    {
+        static block_pool instance;
+        return instance;
+    }
+
+    /**
+     * The size class of a small block of the given bytes.
+     */
+    size_t size_class_of(const size_t bytes)
+    {
+        size_t size_class = 0;
+        while ((size_t(1) << (smallest_class_log2 + size_class)) < bytes)
+        {
+            ++size_class;
+        }
+        return size_class;
+    }
+}
+
+audio_block* brtools::data::detail::acquire_audio_block(const size_t bytes)
+{
+    audio_block* block = nullptr;
+    if (bytes <= small_audio_block_size)
+    {
+        const auto size_class = size_class_of(bytes);
+        block = pool().acquire(size_class);
+        if (block == nullptr)
+        {
+            block = allocate_block(size_t(1) << (smallest_class_log2 + size_class));
+        }
+    }
+    else
+    {
+        block = allocate_block(bytes);
+    }
+
+    block->references.store(1, memory_order_relaxed);
+    return block;
+}
+
+void brtools::data::detail::release_audio_block(audio_block* const block)
+{
+    if (block->capacity > small_audio_block_size || !pool().release(size_class_of(block->capacity), block))
+    {
+        free_block(block);
+    }
+}
@@ -0,0 +1,107 @@
+#include <brtools/data/bank/bank.h>
+#include <brtools/data/bank/parser.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_parser.h>
+#include <iostream>     // for istream
+#include <limits>       // for numeric_limits
+#include <map>
+
+using namespace brtools::io;
+using namespace brtools::data::bank;
+using namespace std;
+
+using brtools::error::integrity_error;
+
+constexpr size_t   bank::key_count;
+constexpr uint16_t bank::no_region;
+
+bank bank::make_bank(istream& stm)
+{
+    stream_parser sp(stm);
+    bank result;
+    {
+        parser rbnk(sp);
+        auto data = rbnk.data();
+        const auto instruments = data.instruments();
+        result._m_instrument_count = instruments.size();
+
+        // regions and rows are shared by the notes and instruments that
+        // refer to the same ones
+        map<parser::data_ref, uint16_t> region_of;
+        map<parser::data_ref, uint16_t> row_of;
+        map<vector<uint16_t>, uint16_t> row_with;
+
+        const auto find_region = [&](const parser::data_ref& ref)
+        {
+            if (ref.type == parser::data_ref::none)
+            {
+                return no_region;
+            }
+            if (ref.type != parser::data_ref::region)
+            {
+                throw integrity_error("RBNK velocity table refers to another table.");
+            }
+            auto it = region_of.find(ref);
+            if (it == region_of.end())
+            {
+                if (result._m_regions.size() == no_region)
+                {
+                    throw integrity_error("RBNK bank has too many regions.");
+                }
+                result._m_regions.push_back(data.read_region(ref));
+                it = region_of.emplace(ref, uint16_t(result._m_regions.size() - 1)).first;
+            }
+            return it->second;
+        };
+
+        const auto find_row = [&](const vector<uint16_t>& row)
+        {
+            auto it = row_with.find(row);
+            if (it == row_with.end())
+            {
+                const auto row_count = result._m_rows.size() / key_count;
+                if (row_count > numeric_limits<uint16_t>::max())
+                {
+                    throw integrity_error("RBNK bank has too many distinct velocity layers.");
+                }
+                result._m_rows.insert(result._m_rows.end(), row.cbegin(), row.cend());
+                it = row_with.emplace(row, uint16_t(row_count)).first;
+            }
+            return it->second;
+        };
+
+        // row 0, of no regions
+        find_row(vector<uint16_t>(key_count, no_region));
+
+        result._m_key_rows.reserve(instruments.size() * key_count);
+        for (const auto& instrument : instruments)
+        {
+            for (const auto& note : data.expand(instrument))
+            {
+                auto it = row_of.find(note);
+                if (it == row_of.end())
+                {
+                    vector<uint16_t> row;
+                    row.reserve(key_count);
+                    for (const auto& velocity : data.expand(note))
+                    {
+                        row.push_back(find_region(velocity));
+                    }
+                    it = row_of.emplace(note, find_row(row)).first;
+                }
+                result._m_key_rows.push_back(it->second);
+            }
+        }
+    }
+    return result;
+}
+
+size_t bank::instrument_count() const
+{
+    return _m_instrument_count;
+}
+
+const vector<region>& bank::regions() const
+{
+    return _m_regions;
+}
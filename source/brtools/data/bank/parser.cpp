@@ -0,0 +1,139 @@
+#include "parser.h"
+#include <brtools/util/integrity_expect.h>
+#include <cstring>      // memcpy
+
+using brtools::util::integrity_expect;
+using namespace brtools::data::bank;
+using namespace brtools::io;
+using namespace std;
+
+parser::parser(stream_parser& sp)
+: file_parser(sp)
+{
+    integrity_expect("file magic", "RBNK", file_magic());
+    integrity_expect("header size", 0x20, file_header_size());
+    integrity_expect("section count", 2, sp.read<uint16_t>());
+    sp >> _m_data_section_ref
+       >> _m_wave_section_ref;
+}
+
+parser::data_section_parser parser::data()
+{
+    _m_sp.seek_by_offset_from_base(_m_data_section_ref.offset());
+    return data_section_parser(_m_sp, _m_data_section_ref.length());
+}
+
+parser::data_section_parser::data_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "DATA", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+}
+
+parser::data_ref parser::data_section_parser::read_ref()
+{
+    data_ref ref;
+    _m_sp.read<uint8_t>();      // whether the reference is an offset
+    ref.type = _m_sp.read<uint8_t>();
+    _m_sp.read<uint16_t>();     // padding
+    ref.offset = _m_sp.read<uint32_t>();
+    if (ref.type > data_ref::index_table)
+    {
+        throw error::integrity_error("RBNK reference is of an unknown type.");
+    }
+    return ref;
+}
+
+vector<parser::data_ref> parser::data_section_parser::instruments()
+{
+    stream_parser::read_scope scope(_m_sp, streamoff(0));
+    const auto count = _m_sp.read<uint32_t>();
+    if (section_length() < 12 || count > (section_length() - 12) / 8)
+    {
+        throw error::integrity_error("DATA section is too short for its instruments.");
+    }
+
+    vector<data_ref> result(count);
+    for (auto& ref : result)
+    {
+        ref = read_ref();
+    }
+    return result;
+}
+
+parser::expansion parser::data_section_parser::expand(const data_ref& ref)
+{
+    expansion result;
+    if (ref.type == data_ref::none || ref.type == data_ref::region)
+    {
+        result.fill(ref);
+        return result;
+    }
+
+    stream_parser::read_scope scope(_m_sp, streamoff(ref.offset));
+    data_ref nothing = { data_ref::none, 0 };
+    result.fill(nothing);
+
+    if (ref.type == data_ref::range_table)
+    {
+        // the last key of each range, in ascending order, then the
+        // references from the next 4-byte boundary
+        const auto size = _m_sp.read<uint8_t>();
+        vector<uint8_t> last_keys(size);
+        for (auto& key : last_keys)
+        {
+            key = _m_sp.read<uint8_t>();
+        }
+        _m_sp.seek_by_offset_from_base(streamoff(ref.offset) + (1 + size + 3) / 4 * 4);
+
+        size_t key = 0;
+        for (const auto last_key : last_keys)
+        {
+            const auto item = read_ref();
+            for (; key <= last_key && key < result.size(); ++key)
+            {
+                result[key] = item;
+            }
+        }
+    }
+    else
+    {
+        const auto first_key = _m_sp.read<uint8_t>();
+        const auto last_key  = _m_sp.read<uint8_t>();
+        _m_sp.read<uint16_t>();     // padding
+        for (size_t key = first_key; key <= last_key; ++key)
+        {
+            const auto item = read_ref();
+            if (key < result.size())
+            {
+                result[key] = item;
+            }
+        }
+    }
+    return result;
+}
+
+region parser::data_section_parser::read_region(const data_ref& ref)
+{
+    stream_parser::read_scope scope(_m_sp, streamoff(ref.offset));
+
+    region result;
+    result.wave_index   = _m_sp.read<int32_t>();
+    result.adsr.attack  = _m_sp.read<uint8_t>();
+    result.adsr.decay   = _m_sp.read<uint8_t>();
+    result.adsr.sustain = _m_sp.read<uint8_t>();
+    result.adsr.release = _m_sp.read<uint8_t>();
+    result.adsr.hold    = _m_sp.read<uint8_t>();
+    _m_sp.read<uint8_t>();      // wave data location type
+    _m_sp.read<uint8_t>();      // note off type
+    _m_sp.read<uint8_t>();      // alternate assign
+    result.original_key = _m_sp.read<uint8_t>();
+    result.volume       = _m_sp.read<uint8_t>();
+    result.pan          = _m_sp.read<uint8_t>();
+    _m_sp.read<uint8_t>();      // surround pan
+
+    const auto tune = _m_sp.read<uint32_t>();
+    static_assert(sizeof(tune) == sizeof(result.tune), "The tune is expected to be a 32-bit float.");
+    memcpy(&result.tune, &tune, sizeof(tune));
+    return result;
+}
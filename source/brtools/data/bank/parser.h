@@ -0,0 +1,87 @@
+#ifndef BRTOOLS_DATA_BANK_PARSER_H
+#define BRTOOLS_DATA_BANK_PARSER_H
+#pragma once
+
+#include <array>
+#include <cstdint>      // uint8_t, uint32_t
+#include <vector>
+
+#include <brtools/data/bank/bank.h>
+#include <brtools/data/types/sized_ref.h>
+
+#include <brtools/io/section_parser.h>
+#include <brtools/io/file_parser.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace bank
+{
+    class parser final : io::file_parser
+    {
+    public:
+        parser(io::stream_parser&);
+
+        /**
+         * A reference within the DATA section to what a note or a velocity
+         * plays: a region, a table splitting the notes or velocities further,
+         * or nothing.
+         */
+        struct data_ref
+        {
+            enum : uint8_t
+            {
+                none        = 0,
+                region      = 1,
+                range_table = 2,
+                index_table = 3,
+            };
+
+            uint8_t  type;
+            uint32_t offset;
+
+            bool operator<(const data_ref& other) const
+            {   return type < other.type || (type == other.type && offset < other.offset);   }
+        };
+
+        /**
+         * What each of the notes or velocities selects.
+         */
+        using expansion = std::array<data_ref, bank::key_count>;
+
+    private:
+        struct data_section_parser final : io::section_parser
+        {
+            data_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            std::vector<data_ref> instruments();
+
+            /**
+             * Resolves what the table referred to selects for every note or
+             * velocity. A reference to a region or to nothing selects itself
+             * for all of them.
+             */
+            expansion expand(const data_ref&);
+
+            /**
+             * @param ref Must refer to a region.
+             */
+            region read_region(const data_ref& ref);
+
+        private:
+            data_ref read_ref();
+        };
+
+    private:
+        types::sized_ref _m_data_section_ref;
+        types::sized_ref _m_wave_section_ref;
+
+    public:
+        data_section_parser data();
+    };
+}
+}
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/error/integrity_error.h>
+#include "dsp_adpcm_kernels.h"
+
+#include <algorithm>    // min
+#include <cstdint>      // int32_t
+
+#if defined(BRTOOLS_DSP_ADPCM_SSE2)
+#include <emmintrin.h>
+#endif
+
+using namespace brtools::data;
+using namespace brtools::data::dsp_adpcm;
+using namespace std;
+
+using brtools::error::integrity_error;
+
+namespace
+{
+    /**
+     * The coefficient pair selected by the header byte of a frame.
+     */
+    const int16_t* coefficient_pair(const coefficients& coefs, const unsigned char header)
+    {
+        const auto index = header >> 4;
+        if (index >= 8)
+        {
+            throw integrity_error("DSP-ADPCM frame selects a coefficient pair out of range.");
+        }
+        return coefs.pairs[index];
+    }
+
+    /**
+     * Predicts a sample from the history and adds the scaled nibble, given
+     * as nibble * scale * 2048 + 1024, so that the sum rounds when shifted.
+     */
+    int16_t predict(const int32_t scaled, const int16_t* const pair, history& hist)
+    {
+        auto sample = (scaled + pair[0] * hist.previous + pair[1] * hist.before_previous) >> 11;
+        sample = min(max(sample, -32768), 32767);
+
+        hist.before_previous = hist.previous;
+        hist.previous        = static_cast<int16_t>(sample);
+        return hist.previous;
+    }
+}
+
+void brtools::data::dsp_adpcm::detail::decode_scalar(const char* frames, const size_t sample_count,
+                                                     const coefficients& coefs, history& hist, int16_t* samples)
+{
+    for (size_t decoded = 0; decoded < sample_count; decoded += samples_per_frame, frames += frame_size)
+    {
+        const auto header = static_cast<unsigned char>(frames[0]);
+        const auto pair   = coefficient_pair(coefs, header);
+        const auto scale  = int32_t(1) << (header & 0xF);
+
+        const auto count = min(samples_per_frame, sample_count - decoded);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto byte = static_cast<unsigned char>(frames[1 + i / 2]);
+            const auto nibble = i % 2 == 0 ? byte >> 4 : byte & 0xF;
+            const auto signed_nibble = nibble >= 8 ? int32_t(nibble) - 16 : int32_t(nibble);
+            *samples++ = predict(signed_nibble * scale * 2048 + 1024, pair, hist);
+        }
+    }
+}
+
+#if defined(BRTOOLS_DSP_ADPCM_SSE2)
+void brtools::data::dsp_adpcm::detail::decode_sse2(const char* frames, const size_t sample_count,
+                                                   const coefficients& coefs, history& hist, int16_t* samples)
+{
+    const auto rounding = _mm_set1_epi32(1024);
+    for (size_t decoded = 0; decoded < sample_count; decoded += samples_per_frame, frames += frame_size)
+    {
+        const auto header = static_cast<unsigned char>(frames[0]);
+        const auto pair   = coefficient_pair(coefs, header);
+        const auto shift  = _mm_cvtsi32_si128((header & 0xF) + 11);
+
+        // a byte per 16-bit lane, in the high half, so that arithmetic
+        // shifts sign-extend its nibbles; lane 0 is the header
+        const auto bytes = _mm_unpacklo_epi8(_mm_setzero_si128(),
+                                             _mm_loadl_epi64(reinterpret_cast<const __m128i*>(frames)));
+        const auto high = _mm_srai_epi16(bytes, 12);
+        const auto low  = _mm_srai_epi16(_mm_slli_epi16(bytes, 4), 12);
+
+        // nibbles in sample order, widened to 32 bits and scaled
+        const auto first = _mm_unpacklo_epi16(high, low);
+        const auto last  = _mm_unpackhi_epi16(high, low);
+        alignas(16) int32_t scaled[16];
+        const __m128i nibbles[4] = { _mm_unpacklo_epi16(first, first), _mm_unpackhi_epi16(first, first),
+                                     _mm_unpacklo_epi16(last, last),   _mm_unpackhi_epi16(last, last) };
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const auto widened = _mm_srai_epi32(nibbles[i], 16);
+            _mm_store_si128(reinterpret_cast<__m128i*>(scaled) + i,
+                            _mm_add_epi32(_mm_sll_epi32(widened, shift), rounding));
+        }
+
+        // the first two are of the header byte
+        const auto count = min(samples_per_frame, sample_count - decoded);
+        for (size_t i = 0; i < count; ++i)
+        {
+            *samples++ = predict(scaled[2 + i], pair, hist);
+        }
+    }
+}
+#endif
+
+void brtools::data::dsp_adpcm::decode(const char* const frames, const size_t sample_count,
+                                      const coefficients& coefs, history& hist, int16_t* const samples)
+{
+#if defined(BRTOOLS_DSP_ADPCM_SSE2)
+    detail::decode_sse2(frames, sample_count, coefs, hist, samples);
+#else
+    detail::decode_scalar(frames, sample_count, coefs, hist, samples);
+#endif
+}
+
+pcm16_audio_data brtools::data::dsp_adpcm::decode(vector<channel>& channels, const size_t sample_count)
+{
+    pcm16_audio_data result(channels.size(), sample_count);
+    for (size_t c = 0; c < channels.size(); ++c)
+    {
+        auto& ch = channels[c];
+        decode(ch.frames, sample_count, ch.coefs, ch.hist, result.channel(c));
+        ch.frames += frame_bytes(sample_count);
+    }
+    return result;
+}
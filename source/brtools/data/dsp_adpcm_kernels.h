@@ -0,0 +1,40 @@
+#ifndef BRTOOLS_DATA_DSP_ADPCM_KERNELS_H
+#define BRTOOLS_DATA_DSP_ADPCM_KERNELS_H
+#pragma once
+
+#include <brtools/data/dsp_adpcm.h>
+
+#include <cstdint>  // int16_t
+#include <cstddef>  // size_t
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BRTOOLS_DSP_ADPCM_SSE2 1
+#endif
+
+namespace brtools
+{
+namespace data
+{
+namespace dsp_adpcm
+{
+namespace detail
+{
+    /**
+     * The reference decoder, a sample at a time.
+     */
+    void decode_scalar(const char* frames, size_t sample_count, const coefficients&, history&, int16_t* samples);
+
+#if defined(BRTOOLS_DSP_ADPCM_SSE2)
+    /**
+     * Unpacks and scales the 14 samples of a frame at once with SSE2, which
+     * every x86-64 processor has, leaving only the prediction to be done a
+     * sample at a time.
+     */
+    void decode_sse2(const char* frames, size_t sample_count, const coefficients&, history&, int16_t* samples);
+#endif
+}
+}
+}
+}
+
+#endif
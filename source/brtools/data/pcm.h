@@ -0,0 +1,47 @@
+#ifndef BRTOOLS_DATA_PCM_H
+#define BRTOOLS_DATA_PCM_H
+#pragma once
+
+#include <cstdint>      // int8_t, int16_t
+#include <cstddef>      // size_t
+#include <cstring>      // memcpy
+
+namespace brtools
+{
+namespace data
+{
+namespace detail
+{
+    /**
+     * Widens 8-bit samples to 16 bits.
+     */
+    inline void decode_pcm8(const char* const data, const size_t sample_count, int16_t* const samples)
+    {
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            samples[i] = static_cast<int16_t>(static_cast<int8_t>(data[i]) * 256);
+        }
+    }
+
+    /**
+     * Copies 16-bit samples, reversing the bytes of each if they are stored
+     * in the reverse byte order of the machine.
+     */
+    inline void decode_pcm16(const char* const data, const size_t sample_count, const bool byte_order_reversed,
+                             int16_t* const samples)
+    {
+        std::memcpy(samples, data, sample_count * sizeof(int16_t));
+        if (byte_order_reversed)
+        {
+            for (size_t i = 0; i < sample_count; ++i)
+            {
+                const auto sample = static_cast<uint16_t>(samples[i]);
+                samples[i] = static_cast<int16_t>((sample >> 8) | (sample << 8));
+            }
+        }
+    }
+}
+}
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <brtools/data/sequence/parse_many.h>
+#include <brtools/data/sequence/events.h>
+#include <brtools/io/memory_stream.h>
+#include <brtools/util/parallel_for.h>
+#include <fstream>      // for ifstream
+#include <ios>          // for ios_base
+#include <iterator>     // for istreambuf_iterator
+#include <algorithm>    // for min
+#include <mutex>
+
+using namespace brtools::data::sequence;
+using namespace brtools::io;
+using namespace std;
+
+using brtools::util::default_thread_count;
+using brtools::util::parallel_for;
+
+namespace
+{
+    /**
+     * Reads the whole file at the given path.
+     */
+    string read_file(const string& path)
+    {
+        ifstream file;
+        file.exceptions(ios_base::failbit | ios_base::badbit);
+        file.open(path, ios_base::binary);
+
+        // reading up to eof would set failbit
+        file.exceptions(ios_base::badbit);
+        return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+}
+
+void brtools::data::sequence::parse_many(const vector<string>& paths, const parse_options& options,
+                                         const function<void(size_t index, sequence&)>& on_parsed,
+                                         const function<void(size_t index, exception_ptr)>& on_error)
+{
+    const auto thread_count = options.thread_count == 0 ? default_thread_count() : options.thread_count;
+    const auto in_flight    = options.max_files_in_flight == 0 ? thread_count : options.max_files_in_flight;
+
+    // every thread holds at most one file at a time, from opening it until
+    // its callback returns, so the threads bound the files in flight
+    mutex callback_mutex;
+    parallel_for(paths.size(), [&](const size_t index)
+                 {
+                     exception_ptr error;
+                     sequence result;
+                     try
+                     {
+                         const auto content = read_file(paths[index]);
+                         memory_istream stm(content.data(), content.size());
+                         result = sequence::make_sequence(stm, options.decoding);
+                     }
+                     catch (...)
+                     {
+                         error = current_exception();
+                     }
+
+                     const lock_guard<mutex> lock(callback_mutex);
+                     if (error)
+                     {
+                         on_error(index, error);
+                     }
+                     else
+                     {
+                         on_parsed(index, result);
+                     }
+                 },
+                 min(thread_count, in_flight));
+}
@@ -34,12 +34,17 @@ parser::data_section_parser::data_section_parser(stream_parser& sp, const uint32
 {
     integrity_expect("section magic", "DATA", section_magic());
     integrity_expect("section length", expected_section_length, section_length());
-    integrity_expect("header length", 0x0C, sp.read<uint32_t>());
+    integrity_expect("header length", 0x0C, _m_header_length = sp.read<uint32_t>());
 
     // event offsets are relative to the first event, which is after the header length
     _m_scope = sp.push_offset_base(sp.tell());
 }
 
+uint32_t parser::data_section_parser::events_length() const
+{
+    return section_length() - _m_header_length;
+}
+
 parser::labl_section_parser::labl_section_parser(stream_parser& sp, const uint32_t expected_section_length)
 : section_parser(sp)
 {
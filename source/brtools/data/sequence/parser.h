@@ -30,7 +30,14 @@ namespace sequence
         {
             data_section_parser(io::stream_parser&, uint32_t expected_section_length);
 
+            /**
+             * The number of bytes following the section header, where the
+             * events are.
+             */
+            uint32_t events_length() const;
+
         private:
+            uint32_t _m_header_length;
             std::unique_ptr<io::stream_parser::offset_scope> _m_scope;
         };
 
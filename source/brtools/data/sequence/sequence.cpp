@@ -2,10 +2,18 @@
 #include <brtools/data/sequence/sequence.h>
 #include <brtools/data/sequence/parser.h>
 #include <brtools/data/sequence/events_impl.h>
+#include <brtools/data/types/variable.h>
+#include <brtools/io/memory_stream.h>
 #include <brtools/io/stream_parser.h>
+#include <brtools/util/parallel_for.h>
 #include <iostream>     // for istream
 #include <utility>      // for move
+#include <algorithm>    // for copy_n, upper_bound, min, max, sort, unique, remove_if
+#include <iterator>     // for prev, advance, distance
+#include <limits>       // for numeric_limits
+#include <exception>    // for exception_ptr, current_exception, rethrow_exception
 #include <forward_list>
+#include <vector>
 #include <stack>
 #include <cassert>
 
@@ -13,6 +21,9 @@ using namespace brtools::io;
 using namespace brtools::data::sequence;
 using namespace std;
 
+namespace types = brtools::data::types;
+using brtools::util::parallel_for;
+
 namespace
 {
     /**
@@ -140,35 +151,185 @@ namespace
     }
 }
 
-sequence sequence::make_sequence(istream& stm)
+namespace
 {
-    stream_parser sp(stm);
-    sequence result;
+    /**
+     * Events decoded from a contiguous range of the DATA section.
+     */
+    struct decoded_chunk
     {
-        parser rseq(sp);
+        sequence::event_container events;
 
         // maps offset to event iterator;
         // offsets are only useful at the time of parsing, because when
         // we support editing, the offsets change all the time and thus
         // not really reliable to be used to map to events.
-        unordered_map<streamoff, event_const_iterator> offset_2_iter;
+        unordered_map<streamoff, sequence::event_const_iterator> offset_2_iter;
 
-        ContainerProxy container{result._m_events, {}};
+        forward_list<tuple<sequence::event_iterator, const resolvable&>> resolvables;
 
-        // DATA section
-        for (auto data = rseq.data(); data.has_data_to_read() && sp.peek<uint8_t>() != 0x00;)
+        // offset following the last event decoded
+        streamoff end = 0;
+
+        // whether a 0x00 byte was reached, which ends the events
+        bool terminated = false;
+
+        // thrown while decoding, if any; only of interest if the chunk is used
+        exception_ptr error;
+    };
+
+    /**
+     * Decodes events from the current position of sp, until the given offset
+     * from base or a 0x00 byte is reached.
+     */
+    void decode_chunk(stream_parser& sp, const streamoff end, decoded_chunk& chunk)
+    {
+        ContainerProxy container{chunk.events, {}};
+
+        while (sp.tell_offset_from_base() < end)
         {
+            if (sp.peek<uint8_t>() == 0x00)
+            {
+                chunk.terminated = true;
+                break;
+            }
+
             // remembers the offset of the current event
             const auto offset = sp.tell_offset_from_base();
 
             if (build_event<>(sp, container))
             {
-                offset_2_iter[offset] = --result._m_events.cend();
+                chunk.offset_2_iter[offset] = --chunk.events.cend();
+            }
+        }
+
+        chunk.resolvables = move(container.resolvables);
+        chunk.end = sp.tell_offset_from_base();
+    }
+
+    /**
+     * Decodes the events in the given bytes concurrently, split at the given
+     * offsets, which are expected to be known event boundaries, such as those
+     * in the LABL section.
+     *
+     * @return Chunks to be concatenated in order. Identical to what decoding
+     *         the bytes from start to end would yield.
+     */
+    vector<decoded_chunk> decode_chunks(const char* const bytes, const streamoff length,
+                                        vector<streamoff> bounds, const bool reverse_byte_order)
+    {
+        bounds.erase(remove_if(bounds.begin(), bounds.end(),
+                               [length](const streamoff offset) { return offset <= 0 || offset >= length; }),
+                     bounds.end());
+        bounds.push_back(0);
+        bounds.push_back(length);
+        sort(bounds.begin(), bounds.end());
+        bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+
+        const auto decode = [&](const streamoff begin, const streamoff end, decoded_chunk& chunk)
+        {
+            memory_istream stm(bytes, length);
+            stream_parser sp(stm);
+            if (reverse_byte_order)
+            {
+                sp.reverse_byte_order();
+            }
+            sp.seek_by_offset_from_base(begin);
+            decode_chunk(sp, end, chunk);
+        };
+
+        vector<decoded_chunk> chunks(bounds.size() - 1);
+        parallel_for(chunks.size(), [&](const size_t i)
+                     {
+                         // a label may point into the middle of an event, from
+                         // where decoding can fail; such a chunk is dropped below
+                         try
+                         {
+                             decode(bounds[i], bounds[i + 1], chunks[i]);
+                         }
+                         catch (...)
+                         {
+                             chunks[i].error = current_exception();
+                         }
+                     });
+
+        // Drops what decoding from the start would not have reached, and bytes
+        // decoded by two chunks, which happens when an event of one chunk runs
+        // past the start of the next.
+        streamoff reached = 0;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (reached >= bounds[i + 1])
+            {
+                // entirely decoded by the previous chunk
+                chunks[i] = decoded_chunk();
+            }
+            else if (reached != bounds[i])
+            {
+                // decoded out of step with the previous chunk; decode again
+                // from where the previous chunk stopped
+                chunks[i] = decoded_chunk();
+                decode(reached, bounds[i + 1], chunks[i]);
+            }
+            else if (chunks[i].error)
+            {
+                rethrow_exception(chunks[i].error);
+            }
+
+            reached = max(reached, chunks[i].end);
+            if (chunks[i].terminated)
+            {
+                chunks.resize(i + 1);
+                break;
+            }
+        }
+        return chunks;
+    }
+}
+
+sequence sequence::make_sequence(istream& stm, const decoding mode)
+{
+    stream_parser sp(stm);
+    sequence result;
+    {
+        parser rseq(sp);
+
+        const auto labels = rseq.labl().labels();
+
+        // DATA section
+        vector<decoded_chunk> chunks;
+        {
+            auto data = rseq.data();
+            const streamoff length = data.events_length();
+
+            if (mode == decoding::parallel && length > 0)
+            {
+                vector<streamoff> bounds;
+                for (const auto& offset_string_pair : labels)
+                {
+                    bounds.push_back(offset_string_pair.first);
+                }
+                chunks = decode_chunks(sp.read_raw(length).get(), length, move(bounds), sp.byte_order_reversed());
+            }
+            else
+            {
+                chunks.emplace_back();
+                decode_chunk(sp, length, chunks.back());
             }
         }
 
+        // concatenates the chunks; iterators to the events remain valid
+        unordered_map<streamoff, event_const_iterator> offset_2_iter;
+        forward_list<tuple<event_iterator, const resolvable&>> resolvables;
+        for (auto& chunk : chunks)
+        {
+            result._m_events.splice(result._m_events.cend(), chunk.events);
+            offset_2_iter.insert(chunk.offset_2_iter.cbegin(), chunk.offset_2_iter.cend());
+            resolvables.splice_after(resolvables.cbefore_begin(), chunk.resolvables);
+        }
+
         // resolve event references
-        for (const auto& iter_resolvable : container.resolvables)
+        for (const auto& iter_resolvable : resolvables)
         {
             // wait for C++17 structured binding
             event_iterator    eit = get<0>(iter_resolvable); 
@@ -186,31 +347,28 @@ sequence sequence::make_sequence(istream& stm)
         }
 
         // LABL section
+        for (const auto& offset_string_pair : labels)
         {
-            auto labl = rseq.labl();
-            for (const auto& offset_string_pair : labl.labels())
+            const auto offset_iter_pair = offset_2_iter.find(offset_string_pair.first);
+            if (offset_iter_pair != offset_2_iter.end())
             {
-                const auto offset_iter_pair = offset_2_iter.find(offset_string_pair.first);
-                if (offset_iter_pair != offset_2_iter.end())
-                {
-                    result._m_label_2_event[offset_string_pair.second] = offset_iter_pair->second;
-                }
+                result._m_label_2_event[offset_string_pair.second] = offset_iter_pair->second;
             }
         }
     }
     return result;
 }
 
-void sequence::traverse(visitor& visitor) const
+namespace
 {
     struct concrete_operation final : visitor::operation
     {
-        void jump(event_const_iterator it) const override
+        void jump(sequence::event_const_iterator it) const override
         {
             _m_next = it;
         }
 
-        void call(event_const_iterator it) const override
+        void call(sequence::event_const_iterator it) const override
         {
             _m_call_stack.push(_m_next);
             jump(it);
@@ -259,9 +417,9 @@ void sequence::traverse(visitor& visitor) const
             jump(_m_end);
         }
 
-        concrete_operation(event_const_iterator& n, event_const_iterator e,
-                           stack<event_const_iterator>& cs,
-                           stack<event_const_iterator>& ls)
+        concrete_operation(sequence::event_const_iterator& n, sequence::event_const_iterator e,
+                           stack<sequence::event_const_iterator>& cs,
+                           stack<sequence::event_const_iterator>& ls)
         : _m_next(n)
         , _m_end(move(e))
         , _m_call_stack(cs)
@@ -269,23 +427,315 @@ void sequence::traverse(visitor& visitor) const
         {}
 
     private:
-        event_const_iterator& _m_next;
-        event_const_iterator  _m_end;
-        stack<event_const_iterator>& _m_call_stack;
-        stack<event_const_iterator>& _m_loop_stack;
+        sequence::event_const_iterator& _m_next;
+        sequence::event_const_iterator  _m_end;
+        stack<sequence::event_const_iterator>& _m_call_stack;
+        stack<sequence::event_const_iterator>& _m_loop_stack;
     };
 
-    stack<event_const_iterator> call_stack;
-    stack<event_const_iterator> loop_stack;
+    /**
+     * Keeps the tick count and tempo of a checkpoint up to date as events are
+     * visited.
+     */
+    struct checkpoint_tracker final : visitor
+    {
+        checkpoint_tracker(sequence::checkpoint& state)
+        : _m_state(state)
+        {}
 
-    for (auto cit = _m_events.cbegin(), cend = _m_events.cend(); 
-         cit != cend;)
+        void visit(const brtools::data::sequence::wait& e, const operation&) override
+        {
+            _m_state.tick += e.tick_count();
+        }
+
+        void visit(const tempo& e, const operation&) override
+        {
+            _m_state.tempo = e.bpm();
+        }
+
+    private:
+        sequence::checkpoint& _m_state;
+    };
+
+    void save_variables(sequence::checkpoint& state, const sequence::variable_memory& variables)
     {
-        // when this assertion fails, we have an unresolved reference
-        assert(cit != event_const_iterator());
+        state.variables.assign(variables.data, variables.data + (variables.data ? variables.size : 0));
+    }
 
-        (*cit)->accept(visitor, concrete_operation(++cit, cend,
-                                                   call_stack, 
-                                                   loop_stack));
+    void restore_variables(const sequence::checkpoint& state, const sequence::variable_memory& variables)
+    {
+        if (variables.data)
+        {
+            copy_n(state.variables.cbegin(), min(state.variables.size(), variables.size), variables.data);
+        }
+    }
+
+    /**
+     * Calls fn with the given variable memory bound to the calling thread,
+     * unless there is none.
+     */
+    template<typename Fn>
+    void with_variables(const sequence::variable_memory& variables, Fn&& fn)
+    {
+        if (variables.data)
+        {
+            const types::variable::memory_binding binding(variables.data, variables.size);
+            fn();
+        }
+        else
+        {
+            fn();
+        }
     }
+
+    /**
+     * Collects the entry points of tracks while visiting events in storage
+     * order.
+     */
+    struct track_finder final : visitor
+    {
+        track_finder(sequence::track_map& tracks, sequence::event_const_iterator end)
+        : _m_tracks(tracks)
+        , _m_end(move(end))
+        {}
+
+        void visit(const track_usage& e, const operation&) override
+        {
+            _m_usage = &e;
+        }
+
+        void visit(const open_track& e, const operation&) override
+        {
+            if (e.track_data() != _m_end && (!_m_usage || _m_usage->is_track_used(e.track_no())))
+            {
+                _m_tracks.emplace(e.track_no(), e.track_data());
+            }
+        }
+
+    private:
+        sequence::track_map&           _m_tracks;
+        sequence::event_const_iterator _m_end;
+        const track_usage*             _m_usage = nullptr;
+    };
+
+    /**
+     * Visits events starting from state.next, until the end of the sequence is
+     * reached or should_stop(state) returns true before visiting an event.
+     */
+    template<typename StopPredicate>
+    void run(visitor& visitor, sequence::checkpoint& state,
+             const sequence::event_const_iterator end, StopPredicate&& should_stop)
+    {
+        checkpoint_tracker tracker(state);
+
+        while (state.next != end && !should_stop(static_cast<const sequence::checkpoint&>(state)))
+        {
+            // when this assertion fails, we have an unresolved reference
+            assert(state.next != sequence::event_const_iterator());
+
+            const auto& e = *state.next;
+            const concrete_operation op(++state.next, end,
+                                        state.call_stack,
+                                        state.loop_stack);
+            e->accept(visitor, op);
+            e->accept(tracker, op);
+        }
+    }
+}
+
+sequence::checkpoint sequence::initial_checkpoint() const
+{
+    checkpoint result;
+    result.next = _m_events.cbegin();
+    return result;
+}
+
+void sequence::traverse(visitor& visitor) const
+{
+    auto state = initial_checkpoint();
+    run(visitor, state, _m_events.cend(), [](const checkpoint&) { return false; });
+}
+
+void sequence::traverse(visitor& visitor, const checkpoint& from, const variable_memory variables) const
+{
+    auto state = from;
+    restore_variables(state, variables);
+    with_variables(variables, [&]
+    {
+        run(visitor, state, _m_events.cend(), [](const checkpoint&) { return false; });
+    });
+}
+
+sequence::checkpoint_table sequence::make_checkpoints(visitor& visitor, const uint32_t tick_interval,
+                                                      const variable_memory variables) const
+{
+    assert(tick_interval != 0);
+
+    checkpoint_table result;
+    auto state = initial_checkpoint();
+    save_variables(state, variables);
+    result.push_back(state);
+
+    uint32_t next_tick = tick_interval;
+    with_variables(variables, [&]
+    {
+        run(visitor, state, _m_events.cend(), [&](const checkpoint& s)
+        {
+            if (s.tick >= next_tick)
+            {
+                result.push_back(s);
+                save_variables(result.back(), variables);
+                // a long wait may have skipped over several intervals
+                next_tick = (s.tick / tick_interval + 1) * tick_interval;
+            }
+            return false;
+        });
+    });
+    return result;
+}
+
+sequence::checkpoint sequence::seek(const checkpoint_table& checkpoints, visitor& fast_forward, const uint32_t tick,
+                                    const variable_memory variables) const
+{
+    // first checkpoint past the tick
+    const auto it = upper_bound(checkpoints.cbegin(), checkpoints.cend(), tick,
+                                [](const uint32_t t, const checkpoint& c) { return t < c.tick; });
+
+    auto state = it == checkpoints.cbegin() ? initial_checkpoint() : *prev(it);
+    restore_variables(state, variables);
+    with_variables(variables, [&]
+    {
+        run(fast_forward, state, _m_events.cend(), [tick](const checkpoint& s) { return s.tick >= tick; });
+    });
+    save_variables(state, variables);
+    return state;
+}
+
+sequence::track_map sequence::tracks() const
+{
+    track_map result;
+    if (!_m_events.empty())
+    {
+        result.emplace(0, _m_events.cbegin());
+
+        // events are visited in storage order, so the operation is unused
+        auto state = initial_checkpoint();
+        track_finder finder(result, _m_events.cend());
+        for (const auto& e : _m_events)
+        {
+            e->accept(finder, concrete_operation(state.next, _m_events.cend(),
+                                                 state.call_stack,
+                                                 state.loop_stack));
+        }
+    }
+    return result;
+}
+
+void sequence::traverse_tracks(const function<visitor&(size_t)>& visitor_of, const track_execution execution,
+                               const function<variable_memory(size_t)>& memory_of) const
+{
+    const auto track_entries = tracks();
+
+    vector<checkpoint> states;
+    vector<reference_wrapper<visitor>> visitors;
+    vector<variable_memory> memories;
+    for (const auto& track : track_entries)
+    {
+        states.emplace_back();
+        states.back().next = track.second;
+        visitors.emplace_back(visitor_of(track.first));
+        memories.push_back(memory_of ? memory_of(track.first) : variable_memory{});
+    }
+
+    const auto end = _m_events.cend();
+    switch (execution)
+    {
+        case track_execution::parallel:
+        {
+            parallel_for(states.size(), [&](const size_t i)
+            {
+                // binds even when there is no memory, so that the track does
+                // not fall back on the memory shared by every thread
+                const types::variable::memory_binding binding(memories[i].data, memories[i].size);
+                run(visitors[i], states[i], end, [](const checkpoint&) { return false; });
+            });
+            break;
+        }
+        case track_execution::interleaved:
+        {
+            for (uint32_t now = 0;;)
+            {
+                auto next_tick = numeric_limits<uint32_t>::max();
+                bool running = false;
+
+                for (size_t i = 0; i < states.size(); ++i)
+                {
+                    // runs the track until it waits past the current tick
+                    with_variables(memories[i], [&]
+                    {
+                        run(visitors[i], states[i], end, [now](const checkpoint& s) { return s.tick > now; });
+                    });
+                    if (states[i].next != end)
+                    {
+                        next_tick = min(next_tick, states[i].tick);
+                        running = true;
+                    }
+                }
+
+                if (!running)
+                {
+                    break;
+                }
+                now = next_tick;
+            }
+            break;
+        }
+    }
+}
+
+vector<sequence::event_const_iterator> sequence::partition_events() const
+{
+    // chunks smaller than this are not worth a thread of their own
+    constexpr size_t min_chunk_size = 4096;
+    // a few chunks per thread evens out uneven visiting costs
+    constexpr size_t chunks_per_thread = 4;
+
+    const auto chunk_count = max<size_t>(1, min(util::default_thread_count() * chunks_per_thread,
+                                                _m_events.size() / min_chunk_size));
+    const auto chunk_size  = _m_events.size() / chunk_count;
+
+    vector<event_const_iterator> result;
+    result.reserve(chunk_count + 1);
+
+    auto it = _m_events.cbegin();
+    if (it != _m_events.cend())
+    {
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+        {
+            result.push_back(it);
+            // the last chunk also takes the remainder
+            advance(it, chunk + 1 < chunk_count ? chunk_size : distance(it, _m_events.cend()));
+        }
+    }
+    result.push_back(_m_events.cend());
+    return result;
+}
+
+void sequence::for_each_event(const vector<event_const_iterator>& bounds, const function<visitor&(size_t)>& visitor_of) const
+{
+    parallel_for(bounds.size() - 1, [&](const size_t chunk)
+    {
+        auto& visitor = visitor_of(chunk);
+
+        // operations are ignored in a linear scan
+        auto state = initial_checkpoint();
+        const concrete_operation op(state.next, _m_events.cend(),
+                                    state.call_stack,
+                                    state.loop_stack);
+
+        for (auto it = bounds[chunk]; it != bounds[chunk + 1]; ++it)
+        {
+            (*it)->accept(visitor, op);
+        }
+    });
 }
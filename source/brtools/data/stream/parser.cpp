@@ -0,0 +1,156 @@
+#include "parser.h"
+#include <brtools/util/integrity_expect.h>
+
+using brtools::util::integrity_expect;
+using namespace brtools::data::stream;
+using namespace brtools::io;
+using namespace std;
+
+namespace
+{
+    /**
+     * Reads a reference within the HEAD section, which is a marker that the
+     * reference is an offset, followed by the offset.
+     */
+    uint32_t read_head_reference(stream_parser& sp)
+    {
+        integrity_expect("reference type", 1, sp.read<uint8_t>());
+        sp.read<uint8_t>();     // data type
+        sp.read<uint16_t>();    // padding
+        return sp.read<uint32_t>();
+    }
+}
+
+parser::parser(stream_parser& sp)
+: file_parser(sp)
+{
+    integrity_expect("file magic", "RSTM", file_magic());
+    integrity_expect("header size", 0x40, file_header_size());
+    sp.read<uint16_t>();    // section count
+    sp >> _m_head_section_ref
+       >> _m_adpc_section_ref
+       >> _m_data_section_ref;
+}
+
+parser::head_section_parser parser::head()
+{
+    _m_sp.seek_by_offset_from_base(_m_head_section_ref.offset());
+    return head_section_parser(_m_sp, _m_head_section_ref.length());
+}
+
+parser::adpc_section_parser parser::adpc()
+{
+    _m_sp.seek_by_offset_from_base(_m_adpc_section_ref.offset());
+    return adpc_section_parser(_m_sp, _m_adpc_section_ref.length());
+}
+
+parser::data_section_parser parser::data()
+{
+    _m_sp.seek_by_offset_from_base(_m_data_section_ref.offset());
+    return data_section_parser(_m_sp, _m_data_section_ref.length());
+}
+
+parser::head_section_parser::head_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "HEAD", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+
+    _m_info_offset = read_head_reference(sp);
+    read_head_reference(sp);    // track information
+    _m_channels_offset = read_head_reference(sp);
+}
+
+parser::stream_info parser::head_section_parser::info()
+{
+    stream_parser::read_scope scope(_m_sp, streamoff(_m_info_offset));
+
+    stream_info info;
+    info.encoding      = _m_sp.read<uint8_t>();
+    info.loops         = _m_sp.read<uint8_t>() != 0;
+    info.channel_count = _m_sp.read<uint8_t>();
+    _m_sp.read<uint8_t>();      // padding
+    info.sample_rate   = _m_sp.read<uint16_t>();
+    _m_sp.read<uint16_t>();     // padding
+    info.loop_start    = _m_sp.read<uint32_t>();
+    info.sample_count  = _m_sp.read<uint32_t>();
+    _m_sp.read<uint32_t>();     // absolute offset to the blocks, also in the DATA section
+    _m_sp >> info.block_count
+          >> info.block_size
+          >> info.block_samples
+          >> info.last_block_size
+          >> info.last_block_samples
+          >> info.last_block_padded_size
+          >> info.adpc_entry_samples
+          >> info.adpc_entry_size;
+    return info;
+}
+
+vector<parser::channel_info> parser::head_section_parser::channels()
+{
+    stream_parser::read_scope scope(_m_sp, streamoff(_m_channels_offset));
+    vector<channel_info> result(_m_sp.read<uint8_t>());
+    _m_sp.read<uint8_t>();      // padding
+    _m_sp.read<uint16_t>();     // padding
+
+    for (auto& channel : result)
+    {
+        stream_parser::read_scope channel_scope(_m_sp, streamoff(read_head_reference(_m_sp)));
+        _m_sp.seek_by_offset_from_base(read_head_reference(_m_sp));
+
+        for (auto& pair : channel.coefs.pairs)
+        {
+            _m_sp >> pair[0] >> pair[1];
+        }
+        _m_sp.read<uint16_t>();     // gain
+        _m_sp.read<uint16_t>();     // initial header byte
+        _m_sp >> channel.hist.previous
+              >> channel.hist.before_previous;
+    }
+    return result;
+}
+
+parser::adpc_section_parser::adpc_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "ADPC", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+}
+
+vector<brtools::data::dsp_adpcm::history> parser::adpc_section_parser::histories(const size_t count)
+{
+    // each history is two 16-bit samples
+    if (section_length() < 8 || count > (section_length() - 8) / 4)
+    {
+        throw error::integrity_error("ADPC section is too short for its histories.");
+    }
+
+    vector<brtools::data::dsp_adpcm::history> result(count);
+    for (auto& hist : result)
+    {
+        _m_sp >> hist.previous
+              >> hist.before_previous;
+    }
+    return result;
+}
+
+parser::data_section_parser::data_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "DATA", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+
+    // the blocks start at an offset from after the section length, which is
+    // typically aligned to 0x20 bytes from the section start
+    sp >> _m_blocks_offset;
+    if (_m_blocks_offset < sizeof(uint32_t) || uint64_t(_m_blocks_offset) + 8 > section_length())
+    {
+        throw error::integrity_error("DATA section blocks start outside the section.");
+    }
+    sp.seek_by_offset_from_base(_m_blocks_offset);
+}
+
+uint32_t parser::data_section_parser::blocks_length() const
+{
+    return section_length() - 8 - _m_blocks_offset;
+}
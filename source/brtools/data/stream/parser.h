@@ -0,0 +1,111 @@
+#ifndef BRTOOLS_DATA_STREAM_PARSER_H
+#define BRTOOLS_DATA_STREAM_PARSER_H
+#pragma once
+
+#include <memory>       // std::unique_ptr
+#include <cstdint>      // uint8_t, uint16_t, uint32_t
+#include <vector>
+
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/data/types/sized_ref.h>
+
+#include <brtools/io/section_parser.h>
+#include <brtools/io/file_parser.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace stream
+{
+    class parser final : io::file_parser
+    {
+    public:
+        parser(io::stream_parser&);
+
+        /**
+         * The stream information in the HEAD section.
+         */
+        struct stream_info
+        {
+            uint8_t  encoding;
+            bool     loops;
+            uint8_t  channel_count;
+            uint16_t sample_rate;
+            uint32_t loop_start;
+            uint32_t sample_count;
+            uint32_t block_count;
+            uint32_t block_size;
+            uint32_t block_samples;
+            uint32_t last_block_size;
+            uint32_t last_block_samples;
+            uint32_t last_block_padded_size;
+            uint32_t adpc_entry_samples;
+            uint32_t adpc_entry_size;
+        };
+
+        /**
+         * The DSP-ADPCM information of a channel in the HEAD section.
+         */
+        struct channel_info
+        {
+            dsp_adpcm::coefficients coefs;
+            dsp_adpcm::history      hist;
+        };
+
+    private:
+        struct head_section_parser final : io::section_parser
+        {
+            head_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            stream_info info();
+            std::vector<channel_info> channels();
+
+        private:
+            uint32_t _m_info_offset;
+            uint32_t _m_channels_offset;
+        };
+
+        struct adpc_section_parser final : io::section_parser
+        {
+            adpc_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            /**
+             * The histories at the start of each block, by block then
+             * channel, for the given number of entries.
+             *
+             * @throws error::integrity_error if the section is too short for
+             *                                them.
+             */
+            std::vector<dsp_adpcm::history> histories(size_t count);
+        };
+
+        struct data_section_parser final : io::section_parser
+        {
+            data_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            /**
+             * The number of bytes following the section header, where the
+             * blocks are.
+             */
+            uint32_t blocks_length() const;
+
+        private:
+            uint32_t _m_blocks_offset;
+        };
+
+    private:
+        types::sized_ref _m_head_section_ref;
+        types::sized_ref _m_adpc_section_ref;
+        types::sized_ref _m_data_section_ref;
+
+    public:
+        head_section_parser head();
+        adpc_section_parser adpc();
+        data_section_parser data();
+    };
+}
+}
+}
+
+#endif
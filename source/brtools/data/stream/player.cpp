@@ -0,0 +1,145 @@
+#include <brtools/data/stream/player.h>
+#include <algorithm>    // for min, copy_n, fill_n
+#include <stdexcept>    // for invalid_argument
+
+using namespace brtools::data::stream;
+using namespace std;
+
+player::player(const stream& s, const buffering& b, const size_t first_sample, const bool looping)
+: _m_stream(s)
+, _m_buffering(b)
+, _m_looping(looping)
+, _m_cursor(s)
+{
+    if (b.read_ahead_frames == 0 || b.slice_frames == 0)
+    {
+        throw invalid_argument("The player must buffer at least a frame.");
+    }
+    _m_cursor.seek(first_sample);
+
+    // slices end early at block boundaries, so a couple more slots keep the
+    // ring from filling up before the frames to read ahead do
+    _m_slots.resize(b.read_ahead_frames / b.slice_frames + 2);
+    _m_thread = thread(&player::decode_ahead, this);
+}
+
+player::player(const stream& s)
+: player(s, buffering())
+{
+}
+
+player::~player()
+{
+    {
+        const lock_guard<mutex> lock(_m_mutex);
+        _m_stopping = true;
+    }
+    _m_stop_requested.notify_one();
+    _m_thread.join();
+}
+
+size_t player::read(int16_t* const* const channels, const size_t frame_count)
+{
+    // loaded before the write index, so that once set, the slices seen are
+    // all there will be
+    const auto decoded_all = _m_decoded_all.load(memory_order_acquire);
+    const auto write_index = _m_write_index.load(memory_order_acquire);
+    auto read_index = _m_read_index.load(memory_order_relaxed);
+
+    size_t copied = 0;
+    while (copied < frame_count && read_index != write_index)
+    {
+        const auto& slice = _m_slots[read_index % _m_slots.size()];
+        const auto count = min(frame_count - copied, slice.frame_count() - _m_read_offset);
+        for (size_t c = 0; c < slice.channel_count(); ++c)
+        {
+            copy_n(slice.channel(c) + _m_read_offset, count, channels[c] + copied);
+        }
+        copied += count;
+
+        _m_read_offset += count;
+        if (_m_read_offset == slice.frame_count())
+        {
+            // hands the slot back to the producer, which releases the slice
+            _m_read_offset = 0;
+            _m_read_index.store(++read_index, memory_order_release);
+        }
+    }
+
+    if (copied > 0)
+    {
+        _m_buffered_frames.fetch_sub(copied, memory_order_relaxed);
+    }
+    if (copied < frame_count)
+    {
+        for (size_t c = 0; c < _m_stream.channel_count(); ++c)
+        {
+            fill_n(channels[c] + copied, frame_count - copied, int16_t(0));
+        }
+        if (!decoded_all)
+        {
+            _m_underruns.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    return copied;
+}
+
+bool player::finished() const
+{
+    return _m_decoded_all.load(memory_order_acquire)
+        && _m_read_index.load(memory_order_relaxed) == _m_write_index.load(memory_order_relaxed);
+}
+
+exception_ptr player::error() const
+{
+    return _m_decoded_all.load(memory_order_acquire) ? _m_error : nullptr;
+}
+
+uint64_t player::underruns() const
+{
+    return _m_underruns.load(memory_order_relaxed);
+}
+
+size_t player::fill_level() const
+{
+    return _m_buffered_frames.load(memory_order_relaxed);
+}
+
+void player::decode_ahead()
+{
+    try
+    {
+        auto write_index = _m_write_index.load(memory_order_relaxed);
+        for (;;)
+        {
+            for (size_t buffered; (buffered = _m_buffered_frames.load(memory_order_relaxed)) < _m_buffering.read_ahead_frames
+                               && write_index - _m_read_index.load(memory_order_acquire) < _m_slots.size();)
+            {
+                const auto count = min(_m_buffering.slice_frames, _m_buffering.read_ahead_frames - buffered);
+                auto slice = _m_looping ? _m_cursor.read_looping(count) : _m_cursor.read(count);
+                if (slice.frame_count() == 0)
+                {
+                    _m_decoded_all.store(true, memory_order_release);
+                    return;
+                }
+
+                // counted before it is published, so that the consumer never
+                // takes away frames not counted yet
+                _m_buffered_frames.fetch_add(slice.frame_count(), memory_order_relaxed);
+                _m_slots[write_index % _m_slots.size()] = move(slice);
+                _m_write_index.store(++write_index, memory_order_release);
+            }
+
+            unique_lock<mutex> lock(_m_mutex);
+            if (_m_stop_requested.wait_for(lock, _m_buffering.refill_interval, [this] { return _m_stopping; }))
+            {
+                return;
+            }
+        }
+    }
+    catch (...)
+    {
+        _m_error = current_exception();
+        _m_decoded_all.store(true, memory_order_release);
+    }
+}
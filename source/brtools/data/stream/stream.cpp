@@ -0,0 +1,308 @@
+#include <brtools/data/stream/stream.h>
+#include <brtools/data/stream/parser.h>
+#include <brtools/data/pcm.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_parser.h>
+#include <brtools/util/integrity_expect.h>
+#include <brtools/util/parallel_for.h>
+#include <iostream>     // for istream
+#include <algorithm>    // for min
+#include <stdexcept>    // for out_of_range
+#include <cstdint>      // for uint64_t
+
+using namespace brtools::io;
+using namespace brtools::data::stream;
+using namespace std;
+
+using brtools::data::encoding;
+using brtools::data::detail::decode_pcm8;
+using brtools::data::detail::decode_pcm16;
+using brtools::data::pcm16_audio_data;
+using brtools::error::integrity_error;
+using brtools::util::integrity_expect;
+using brtools::util::parallel_for;
+
+namespace dsp_adpcm = brtools::data::dsp_adpcm;
+
+namespace
+{
+    /**
+     * The bytes a block of the given encoding takes to store the given
+     * number of samples of one channel.
+     */
+    size_t bytes_of_samples(const encoding enc, const size_t sample_count)
+    {
+        switch (enc)
+        {
+        case encoding::pcm8:  return sample_count;
+        case encoding::pcm16: return sample_count * sizeof(int16_t);
+        case encoding::adpcm: return dsp_adpcm::frame_bytes(sample_count);
+        }
+        return 0;
+    }
+}
+
+stream stream::make_stream(istream& stm)
+{
+    stream_parser sp(stm);
+    stream result;
+    {
+        parser rstm(sp);
+
+        // HEAD section
+        vector<parser::channel_info> channels;
+        parser::stream_info info;
+        {
+            auto head = rstm.head();
+            info = head.info();
+            if (info.encoding > static_cast<uint8_t>(encoding::adpcm))
+            {
+                throw integrity_error("RSTM stream has an unknown encoding.");
+            }
+            result._m_encoding = static_cast<encoding>(info.encoding);
+
+            if (result._m_encoding == encoding::adpcm)
+            {
+                channels = head.channels();
+                integrity_expect("channel count", unsigned(info.channel_count), channels.size());
+            }
+        }
+
+        result._m_loops          = info.loops;
+        result._m_channel_count  = info.channel_count;
+        result._m_sample_rate    = info.sample_rate;
+        result._m_loop_start     = info.loop_start;
+        result._m_sample_count   = info.sample_count;
+        result._m_block_count    = info.block_count;
+        result._m_block_size     = info.block_size;
+        result._m_block_samples  = info.block_samples;
+        result._m_last_block_size = info.last_block_padded_size;
+        result._m_byte_order_reversed = sp.byte_order_reversed();
+
+        if (result._m_channel_count == 0 || result._m_block_count == 0 || result._m_sample_count == 0)
+        {
+            throw integrity_error("RSTM stream has no channels or no samples.");
+        }
+        if (result._m_block_samples == 0)
+        {
+            throw integrity_error("RSTM blocks have no samples.");
+        }
+        integrity_expect("sample count", (info.block_count - 1) * size_t(info.block_samples) + info.last_block_samples,
+                         result._m_sample_count);
+        if (bytes_of_samples(result._m_encoding, info.block_samples) > info.block_size
+         || bytes_of_samples(result._m_encoding, info.last_block_samples) > info.last_block_padded_size)
+        {
+            throw integrity_error("RSTM block is too small for its samples.");
+        }
+        if (result._m_loops && result._m_loop_start >= result._m_sample_count)
+        {
+            throw integrity_error("RSTM loop starts past the last sample.");
+        }
+
+        // ADPC section
+        if (result._m_encoding == encoding::adpcm)
+        {
+            integrity_expect("samples per ADPC entry", info.block_samples, info.adpc_entry_samples);
+            // an entry holds the history of one channel, and a block has one
+            // entry per channel
+            integrity_expect("bytes per ADPC entry", 4u, info.adpc_entry_size);
+            result._m_block_histories = rstm.adpc().histories(result._m_block_count * result._m_channel_count);
+
+            // the first block starts from the history in the HEAD section
+            for (size_t channel = 0; channel < channels.size(); ++channel)
+            {
+                result._m_coefficients.push_back(channels[channel].coefs);
+                result._m_block_histories[channel] = channels[channel].hist;
+            }
+        }
+
+        // DATA section
+        {
+            auto data = rstm.data();
+
+            // the sizes come from the file, so a channel's blocks are
+            // checked before they are multiplied by the channel count;
+            // neither step can wrap in 64 bits
+            const auto channel_length = (uint64_t(result._m_block_count) - 1) * uint64_t(result._m_block_size)
+                                      + result._m_last_block_size;
+            if (channel_length > data.blocks_length() / result._m_channel_count)
+            {
+                throw integrity_error("RSTM blocks run past the DATA section.");
+            }
+            result._m_data = sp.read_raw(static_cast<size_t>(result._m_channel_count * channel_length));
+        }
+    }
+    return result;
+}
+
+encoding stream::stream_encoding() const
+{
+    return _m_encoding;
+}
+
+size_t stream::channel_count() const
+{
+    return _m_channel_count;
+}
+
+uint16_t stream::sample_rate() const
+{
+    return _m_sample_rate;
+}
+
+size_t stream::sample_count() const
+{
+    return _m_sample_count;
+}
+
+bool stream::loops() const
+{
+    return _m_loops;
+}
+
+size_t stream::loop_start() const
+{
+    return _m_loop_start;
+}
+
+size_t stream::block_count() const
+{
+    return _m_block_count;
+}
+
+size_t stream::block_samples() const
+{
+    return _m_block_samples;
+}
+
+const dsp_adpcm::coefficients& stream::coefficients(const size_t channel) const
+{
+    return _m_coefficients.at(channel);
+}
+
+pcm16_audio_data stream::decode(const decoding mode) const
+{
+    pcm16_audio_data result(_m_channel_count, _m_sample_count);
+    const auto decode_one = [this, &result](const size_t i)
+    {
+        const auto block   = i / _m_channel_count;
+        const auto channel = i % _m_channel_count;
+        decode_block(block, channel, result.channel(channel) + block * _m_block_samples);
+    };
+
+    const auto count = _m_block_count * _m_channel_count;
+    if (mode == decoding::parallel)
+    {
+        parallel_for(count, decode_one);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            decode_one(i);
+        }
+    }
+    return result;
+}
+
+stream::cursor::cursor(const stream& s)
+: _m_stream(&s)
+, _m_position(0)
+, _m_block(s._m_block_count)
+{
+}
+
+void stream::cursor::seek(const size_t sample)
+{
+    if (sample > _m_stream->_m_sample_count)
+    {
+        throw out_of_range("The sample to seek to is past the end of the stream.");
+    }
+    _m_position = sample;
+}
+
+size_t stream::cursor::tell() const
+{
+    return _m_position;
+}
+
+pcm16_audio_data stream::cursor::read(const size_t count)
+{
+    const auto& s = *_m_stream;
+    if (_m_position == s._m_sample_count || count == 0)
+    {
+        return pcm16_audio_data();
+    }
+
+    const auto block = _m_position / s._m_block_samples;
+    if (block != _m_block)
+    {
+        _m_decoded = s.decode_block(block);
+        _m_block   = block;
+    }
+
+    const auto offset = _m_position - block * s._m_block_samples;
+    const auto result = _m_decoded.slice(offset, min(count, _m_decoded.frame_count() - offset));
+    _m_position += result.frame_count();
+    return result;
+}
+
+pcm16_audio_data stream::cursor::read_looping(const size_t count)
+{
+    if (_m_position == _m_stream->_m_sample_count && _m_stream->_m_loops)
+    {
+        seek(_m_stream->_m_loop_start);
+    }
+    return read(count);
+}
+
+pcm16_audio_data stream::decode_block(const size_t block) const
+{
+    pcm16_audio_data result(_m_channel_count, samples_in_block(block));
+    for (size_t channel = 0; channel < _m_channel_count; ++channel)
+    {
+        decode_block(block, channel, result.channel(channel));
+    }
+    return result;
+}
+
+void stream::decode_block(const size_t block, const size_t channel, int16_t* const samples) const
+{
+    const auto data  = block_data(block, channel);
+    const auto count = samples_in_block(block);
+    switch (_m_encoding)
+    {
+    case encoding::pcm8:
+        decode_pcm8(data, count, samples);
+        break;
+
+    case encoding::pcm16:
+        decode_pcm16(data, count, _m_byte_order_reversed, samples);
+        break;
+
+    case encoding::adpcm:
+        {
+            auto hist = block_history(block, channel);
+            dsp_adpcm::decode(data, count, _m_coefficients[channel], hist, samples);
+        }
+        break;
+    }
+}
+
+dsp_adpcm::history stream::block_history(const size_t block, const size_t channel) const
+{
+    return _m_block_histories[block * _m_channel_count + channel];
+}
+
+const char* stream::block_data(const size_t block, const size_t channel) const
+{
+    // every block but the last is of the same size
+    const auto block_size = block + 1 < _m_block_count ? _m_block_size : _m_last_block_size;
+    return _m_data.get() + block * _m_channel_count * _m_block_size + channel * block_size;
+}
+
+size_t stream::samples_in_block(const size_t block) const
+{
+    return block + 1 < _m_block_count ? _m_block_samples
+                                      : _m_sample_count - (_m_block_count - 1) * _m_block_samples;
+}
@@ -4,23 +4,55 @@
 using namespace brtools::data::types;
 using brtools::io::stream_parser;
 
+constexpr size_t variable::memory_size;
 int16_t* variable::memory = nullptr;
 
+namespace
+{
+    /**
+     * The innermost binding of the calling thread, if any.
+     */
+    thread_local const variable::memory_binding* current_binding = nullptr;
+}
+
+variable::memory_binding::memory_binding(int16_t* const data, const size_t size)
+: _m_data(data)
+, _m_size(data ? size : 0)
+, _m_previous(current_binding)
+{
+    current_binding = this;
+}
+
+variable::memory_binding::~memory_binding()
+{
+    current_binding = _m_previous;
+}
+
 uint8_t variable::slot() const
 {
     return _m_slot;
 }
 
+int16_t* variable::slot_memory() const
+{
+    if (current_binding)
+    {
+        return _m_slot < current_binding->_m_size ? current_binding->_m_data + _m_slot : nullptr;
+    }
+    return memory ? memory + _m_slot : nullptr;
+}
+
 variable::operator int16_t() const
 {
-    return memory ? memory[_m_slot] : 0;
+    const auto m = slot_memory();
+    return m ? *m : 0;
 }
 
 const variable& variable::operator=(const int16_t new_value) const
 {
-    if (memory)
+    if (const auto m = slot_memory())
     {
-        memory[_m_slot] = new_value;
+        *m = new_value;
     }
 
     return *this;
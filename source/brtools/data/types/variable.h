@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>   // size_t
 
 namespace brtools
 {
@@ -17,9 +18,38 @@ namespace types
 {
     struct variable
     {
+        /**
+         * Number of variable slots addressable by a sequence: 16 local,
+         * 16 global and 16 track variables.
+         */
+        static constexpr size_t memory_size = 48;
+
         // wait for C++20 and use std::span
         static int16_t* memory;
 
+        /**
+         * Makes the calling thread use the given slots in place of memory for
+         * as long as the binding exists. Slots at or past size read as 0 and
+         * ignore writes. Bindings nest; destroying one restores what the
+         * thread used before.
+         */
+        class memory_binding
+        {
+        public:
+            memory_binding(int16_t* data, size_t size);
+            ~memory_binding();
+
+            memory_binding(const memory_binding&) = delete;
+            memory_binding& operator=(const memory_binding&) = delete;
+
+        private:
+            int16_t*              _m_data;
+            size_t                _m_size;
+            const memory_binding* _m_previous;
+
+            friend struct variable;
+        };
+
         uint8_t slot() const;
         
         operator int16_t() const;
@@ -38,6 +68,12 @@ namespace types
         const variable& operator~  (               ) const;
 
     private:
+        /**
+         * The memory of the slot on the calling thread, or nullptr if there
+         * is none.
+         */
+        int16_t* slot_memory() const;
+
         uint8_t _m_slot;
 
         friend 
@@ -0,0 +1,54 @@
+#include <brtools/data/wave/archive.h>
+#include <brtools/data/wave/parser.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/memory_stream.h>
+#include <brtools/io/stream_parser.h>
+#include <cstdint>      // for uint64_t
+
+using namespace brtools::io;
+using namespace brtools::data::wave;
+using namespace std;
+
+using brtools::error::integrity_error;
+
+archive archive::make_archive(const char* const data, const size_t size)
+{
+    memory_istream stm(data, size);
+    stream_parser sp(stm);
+    archive result;
+    {
+        rwar_parser rwar(sp);
+        const auto entries = rwar.table().entries();
+
+        // the waves are at offsets from the start of the DATA section, and
+        // are left there
+        auto section = rwar.data();
+        const auto start = static_cast<streamoff>(section.body()) - 8;
+        if (uint64_t(start) + section.section_length() > size)
+        {
+            throw integrity_error("RWAR DATA section runs past the bytes it is read from.");
+        }
+
+        result._m_entries.reserve(entries.size());
+        for (const auto& entry : entries)
+        {
+            if (uint64_t(entry.offset) + entry.length > section.section_length())
+            {
+                throw integrity_error("RWAR wave runs past the DATA section.");
+            }
+            result._m_entries.push_back({ data + start + entry.offset, entry.length });
+        }
+    }
+    return result;
+}
+
+size_t archive::size() const
+{
+    return _m_entries.size();
+}
+
+wave archive::at(const size_t index) const
+{
+    const auto& entry = _m_entries.at(index);
+    return wave::make_wave(entry.data, entry.size);
+}
@@ -0,0 +1,158 @@
+#include "parser.h"
+#include <brtools/util/integrity_expect.h>
+
+using brtools::util::integrity_expect;
+using namespace brtools::data::wave;
+using namespace brtools::io;
+using namespace std;
+
+data_section_parser::data_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+, _m_body(sp.tell())
+{
+    integrity_expect("section magic", "DATA", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+    if (section_length() < 8)
+    {
+        throw error::integrity_error("DATA section is shorter than its header.");
+    }
+}
+
+streampos data_section_parser::body() const
+{
+    return _m_body;
+}
+
+uint32_t data_section_parser::body_length() const
+{
+    return section_length() - 8;
+}
+
+rwav_parser::rwav_parser(stream_parser& sp)
+: file_parser(sp)
+{
+    integrity_expect("file magic", "RWAV", file_magic());
+    integrity_expect("header size", 0x20, file_header_size());
+    integrity_expect("section count", 2, sp.read<uint16_t>());
+    sp >> _m_info_section_ref
+       >> _m_data_section_ref;
+}
+
+rwav_parser::info_section_parser rwav_parser::info()
+{
+    _m_sp.seek_by_offset_from_base(_m_info_section_ref.offset());
+    return info_section_parser(_m_sp, _m_info_section_ref.length());
+}
+
+data_section_parser rwav_parser::data()
+{
+    _m_sp.seek_by_offset_from_base(_m_data_section_ref.offset());
+    return data_section_parser(_m_sp, _m_data_section_ref.length());
+}
+
+rwav_parser::info_section_parser::info_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "INFO", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+
+    _m_info.encoding      = sp.read<uint8_t>();
+    _m_info.loops         = sp.read<uint8_t>() != 0;
+    _m_info.channel_count = sp.read<uint8_t>();
+
+    // 24 bits, the highest 8 first
+    _m_info.sample_rate   = uint32_t(sp.read<uint8_t>()) << 16;
+    _m_info.sample_rate  |= sp.read<uint16_t>();
+    sp.read<uint8_t>();     // data location type
+    sp.read<uint8_t>();     // padding
+    _m_info.loop_start    = sp.read<uint32_t>();
+    _m_info.loop_end      = sp.read<uint32_t>();
+    _m_channels_offset    = sp.read<uint32_t>();
+    _m_info.data_location = sp.read<uint32_t>();
+}
+
+rwav_parser::wave_info rwav_parser::info_section_parser::info() const
+{
+    return _m_info;
+}
+
+vector<rwav_parser::channel_info> rwav_parser::info_section_parser::channels(const bool adpcm)
+{
+    stream_parser::read_scope scope(_m_sp, streamoff(_m_channels_offset));
+    vector<channel_info> result(_m_info.channel_count);
+
+    for (auto& channel : result)
+    {
+        stream_parser::read_scope channel_scope(_m_sp, streamoff(_m_sp.read<uint32_t>()));
+        channel.data_offset = _m_sp.read<uint32_t>();
+        const auto adpcm_offset = _m_sp.read<uint32_t>();
+        if (!adpcm)
+        {
+            continue;
+        }
+
+        _m_sp.seek_by_offset_from_base(adpcm_offset);
+        for (auto& pair : channel.coefs.pairs)
+        {
+            _m_sp >> pair[0] >> pair[1];
+        }
+        _m_sp.read<uint16_t>();     // gain
+        _m_sp.read<uint16_t>();     // initial header byte
+        _m_sp >> channel.hist.previous
+              >> channel.hist.before_previous;
+        _m_sp.read<uint16_t>();     // loop header byte
+        _m_sp >> channel.loop_hist.previous
+              >> channel.loop_hist.before_previous;
+    }
+    return result;
+}
+
+rwar_parser::rwar_parser(stream_parser& sp)
+: file_parser(sp)
+{
+    integrity_expect("file magic", "RWAR", file_magic());
+    integrity_expect("header size", 0x20, file_header_size());
+    integrity_expect("section count", 2, sp.read<uint16_t>());
+    sp >> _m_tabl_section_ref
+       >> _m_data_section_ref;
+}
+
+rwar_parser::tabl_section_parser rwar_parser::table()
+{
+    _m_sp.seek_by_offset_from_base(_m_tabl_section_ref.offset());
+    return tabl_section_parser(_m_sp, _m_tabl_section_ref.length());
+}
+
+data_section_parser rwar_parser::data()
+{
+    _m_sp.seek_by_offset_from_base(_m_data_section_ref.offset());
+    return data_section_parser(_m_sp, _m_data_section_ref.length());
+}
+
+rwar_parser::tabl_section_parser::tabl_section_parser(stream_parser& sp, const uint32_t expected_section_length)
+: section_parser(sp)
+{
+    integrity_expect("section magic", "TABL", section_magic());
+    integrity_expect("section length", expected_section_length, section_length());
+}
+
+vector<rwar_parser::table_entry> rwar_parser::tabl_section_parser::entries()
+{
+    stream_parser::read_scope scope(_m_sp);
+    const auto count = _m_sp.read<uint32_t>();
+    if (section_length() < 12 || count > (section_length() - 12) / 12)
+    {
+        throw error::integrity_error("TABL section is too short for its entries.");
+    }
+
+    vector<table_entry> result(count);
+    for (auto& entry : result)
+    {
+        integrity_expect("reference type", 1, _m_sp.read<uint8_t>());
+        _m_sp.read<uint8_t>();      // data type
+        _m_sp.read<uint16_t>();     // padding
+        _m_sp >> entry.offset
+              >> entry.length;
+    }
+    return result;
+}
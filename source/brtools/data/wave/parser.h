@@ -0,0 +1,134 @@
+#ifndef BRTOOLS_DATA_WAVE_PARSER_H
+#define BRTOOLS_DATA_WAVE_PARSER_H
+#pragma once
+
+#include <cstdint>      // uint8_t, uint32_t
+#include <ios>          // std::streampos
+#include <vector>
+
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/data/types/sized_ref.h>
+
+#include <brtools/io/section_parser.h>
+#include <brtools/io/file_parser.h>
+
+namespace brtools
+{
+namespace data
+{
+namespace wave
+{
+    /**
+     * The DATA section of an RWAV or an RWAR file, which is read in place.
+     */
+    struct data_section_parser final : io::section_parser
+    {
+        data_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+        /**
+         * The position after the section header, where the data is.
+         */
+        std::streampos body() const;
+        uint32_t       body_length() const;
+
+    private:
+        std::streampos _m_body;
+    };
+
+    class rwav_parser final : io::file_parser
+    {
+    public:
+        rwav_parser(io::stream_parser&);
+
+        using io::file_parser::file_size;
+
+        /**
+         * The wave information in the INFO section. The loop points are in
+         * samples, or in nibbles for DSP-ADPCM; the loop end is the last
+         * one played.
+         */
+        struct wave_info
+        {
+            uint8_t  encoding;
+            bool     loops;
+            uint8_t  channel_count;
+            uint32_t sample_rate;
+            uint32_t loop_start;
+            uint32_t loop_end;
+            uint32_t data_location;
+        };
+
+        struct channel_info
+        {
+            /**
+             * The offset of the samples from data_location.
+             */
+            uint32_t                data_offset;
+            dsp_adpcm::coefficients coefs;
+            dsp_adpcm::history      hist;
+            dsp_adpcm::history      loop_hist;
+        };
+
+    private:
+        struct info_section_parser final : io::section_parser
+        {
+            info_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            wave_info info() const;
+
+            /**
+             * @param adpcm Whether the channels have DSP-ADPCM information
+             *              to read.
+             */
+            std::vector<channel_info> channels(bool adpcm);
+
+        private:
+            wave_info _m_info;
+            uint32_t  _m_channels_offset;
+        };
+
+    private:
+        types::sized_ref _m_info_section_ref;
+        types::sized_ref _m_data_section_ref;
+
+    public:
+        info_section_parser info();
+        data_section_parser data();
+    };
+
+    class rwar_parser final : io::file_parser
+    {
+    public:
+        rwar_parser(io::stream_parser&);
+
+        /**
+         * A wave in the DATA section, at an offset from the start of the
+         * section.
+         */
+        struct table_entry
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+    private:
+        struct tabl_section_parser final : io::section_parser
+        {
+            tabl_section_parser(io::stream_parser&, uint32_t expected_section_length);
+
+            std::vector<table_entry> entries();
+        };
+
+    private:
+        types::sized_ref _m_tabl_section_ref;
+        types::sized_ref _m_data_section_ref;
+
+    public:
+        tabl_section_parser table();
+        data_section_parser data();
+    };
+}
+}
+}
+
+#endif
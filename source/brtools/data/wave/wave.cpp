@@ -0,0 +1,165 @@
+#include <brtools/data/wave/wave.h>
+#include <brtools/data/wave/parser.h>
+#include <brtools/data/pcm.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/memory_stream.h>
+#include <brtools/io/stream_parser.h>
+#include <cstdint>      // for uint64_t
+
+using namespace brtools::io;
+using namespace brtools::data::wave;
+using namespace std;
+
+using brtools::data::encoding;
+using brtools::data::detail::decode_pcm8;
+using brtools::data::detail::decode_pcm16;
+using brtools::data::pcm16_audio_data;
+using brtools::error::integrity_error;
+
+namespace dsp_adpcm = brtools::data::dsp_adpcm;
+
+wave wave::make_wave(const char* const data, const size_t size)
+{
+    memory_istream stm(data, size);
+    stream_parser sp(stm);
+    wave result;
+    {
+        rwav_parser rwav(sp);
+        if (rwav.file_size() > size)
+        {
+            throw integrity_error("RWAV file runs past the bytes it is read from.");
+        }
+
+        // INFO section
+        rwav_parser::wave_info info;
+        vector<rwav_parser::channel_info> channels;
+        {
+            auto section = rwav.info();
+            info = section.info();
+            if (info.encoding > static_cast<uint8_t>(encoding::adpcm))
+            {
+                throw integrity_error("RWAV wave has an unknown encoding.");
+            }
+            result._m_encoding = static_cast<encoding>(info.encoding);
+            channels = section.channels(result._m_encoding == encoding::adpcm);
+        }
+
+        // loop points of DSP-ADPCM waves are nibble addresses
+        const auto loop_end = uint64_t(info.loop_end) + 1;
+        if (result._m_encoding == encoding::adpcm)
+        {
+            result._m_loop_start   = dsp_adpcm::nibble_address_to_samples(info.loop_start);
+            result._m_sample_count = dsp_adpcm::nibble_address_to_samples(loop_end);
+        }
+        else
+        {
+            result._m_loop_start   = info.loop_start;
+            result._m_sample_count = loop_end;
+        }
+        result._m_loops       = info.loops;
+        result._m_sample_rate = info.sample_rate;
+        result._m_byte_order_reversed = sp.byte_order_reversed();
+
+        if (channels.empty())
+        {
+            throw integrity_error("RWAV wave has no channels.");
+        }
+        if (result._m_loops && result._m_loop_start >= result._m_sample_count)
+        {
+            throw integrity_error("RWAV loop starts past the last sample.");
+        }
+
+        // DATA section, which the samples are left in
+        {
+            auto section = rwav.data();
+            const auto body = static_cast<streamoff>(section.body());
+            if (uint64_t(body) + section.body_length() > size)
+            {
+                throw integrity_error("RWAV DATA section runs past the bytes it is read from.");
+            }
+            for (const auto& channel : channels)
+            {
+                const auto offset = uint64_t(info.data_location) + channel.data_offset;
+                if (offset + result.sample_bytes() > section.body_length())
+                {
+                    throw integrity_error("RWAV samples run past the DATA section.");
+                }
+                result._m_channels.push_back({ data + body + offset, channel.coefs, channel.hist, channel.loop_hist });
+            }
+        }
+    }
+    return result;
+}
+
+encoding wave::wave_encoding() const
+{
+    return _m_encoding;
+}
+
+uint32_t wave::sample_rate() const
+{
+    return _m_sample_rate;
+}
+
+size_t wave::channel_count() const
+{
+    return _m_channels.size();
+}
+
+size_t wave::sample_count() const
+{
+    return _m_sample_count;
+}
+
+bool wave::loops() const
+{
+    return _m_loops;
+}
+
+size_t wave::loop_start() const
+{
+    return _m_loop_start;
+}
+
+const wave::channel& wave::channel_at(const size_t index) const
+{
+    return _m_channels.at(index);
+}
+
+size_t wave::sample_bytes() const
+{
+    switch (_m_encoding)
+    {
+    case encoding::pcm8:  return _m_sample_count;
+    case encoding::pcm16: return _m_sample_count * sizeof(int16_t);
+    case encoding::adpcm: return dsp_adpcm::frame_bytes(_m_sample_count);
+    }
+    return 0;
+}
+
+pcm16_audio_data wave::decode() const
+{
+    pcm16_audio_data result(_m_channels.size(), _m_sample_count);
+    for (size_t c = 0; c < _m_channels.size(); ++c)
+    {
+        const auto& channel = _m_channels[c];
+        switch (_m_encoding)
+        {
+        case encoding::pcm8:
+            decode_pcm8(channel.samples, _m_sample_count, result.channel(c));
+            break;
+
+        case encoding::pcm16:
+            decode_pcm16(channel.samples, _m_sample_count, _m_byte_order_reversed, result.channel(c));
+            break;
+
+        case encoding::adpcm:
+            {
+                auto hist = channel.hist;
+                dsp_adpcm::decode(channel.samples, _m_sample_count, channel.coefs, hist, result.channel(c));
+            }
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,43 @@
+#include "memory_stream.h"
+
+using namespace brtools::io;
+using namespace std;
+
+memory_streambuf::memory_streambuf(const char* const data, const size_t size)
+{
+    // the get area is never written to, since putback is not supported
+    const auto begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+memory_streambuf::pos_type memory_streambuf::seekoff(const off_type off, const ios_base::seekdir dir, const ios_base::openmode which)
+{
+    off_type base;
+    switch (dir)
+    {
+        case ios_base::beg: base = 0; break;
+        case ios_base::cur: base = gptr() - eback(); break;
+        case ios_base::end: base = egptr() - eback(); break;
+        default: return pos_type(off_type(-1));
+    }
+    return seekpos(pos_type(base + off), which);
+}
+
+memory_streambuf::pos_type memory_streambuf::seekpos(const pos_type pos, const ios_base::openmode which)
+{
+    const off_type off = pos;
+    if (!(which & ios_base::in) || off < 0 || off > egptr() - eback())
+    {
+        return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + off, egptr());
+    return pos;
+}
+
+memory_istream::memory_istream(const char* const data, const size_t size)
+: istream(nullptr)
+, _m_buffer(data, size)
+{
+    rdbuf(&_m_buffer);
+}
@@ -0,0 +1,46 @@
+#ifndef BRTOOLS_IO_MEMORY_STREAM_H
+#define BRTOOLS_IO_MEMORY_STREAM_H
+#pragma once
+
+#include <istream>
+#include <streambuf>
+#include <cstddef>  // size_t
+
+namespace brtools
+{
+namespace io
+{
+    /**
+     * Stream buffer reading from a range of bytes in memory. The bytes are
+     * not copied, so they must outlive this buffer.
+     */
+    class memory_streambuf : public std::streambuf
+    {
+    public:
+        memory_streambuf(const char* data, size_t size);
+
+    protected:
+        pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override;
+        pos_type seekpos(pos_type, std::ios_base::openmode) override;
+    };
+
+    /**
+     * Input stream reading from a range of bytes in memory, so it can be read
+     * by a stream_parser. The bytes are not copied, so they must outlive this
+     * stream.
+     *
+     * Independent memory_istreams over the same bytes can be read from
+     * different threads at the same time.
+     */
+    class memory_istream : public std::istream
+    {
+    public:
+        memory_istream(const char* data, size_t size);
+
+    private:
+        memory_streambuf _m_buffer;
+    };
+}
+}
+
+#endif
@@ -17,7 +17,29 @@ void stream_parser::reverse_byte_order()
     _m_should_reverse_bytes = !_m_should_reverse_bytes;
 }
 
+bool stream_parser::byte_order_reversed() const
+{
+    return _m_should_reverse_bytes;
+}
+
 unique_ptr<const char[]> stream_parser::read(const size_t number_of_bytes)
+{
+    auto ret = read_bytes(number_of_bytes);
+
+    if (_m_should_reverse_bytes)
+    {
+        reverse(&ret[0], &ret[number_of_bytes]);
+    }
+
+    return ret;
+}
+
+unique_ptr<const char[]> stream_parser::read_raw(const size_t number_of_bytes)
+{
+    return read_bytes(number_of_bytes);
+}
+
+unique_ptr<char[]> stream_parser::read_bytes(const size_t number_of_bytes)
 {
     if (number_of_bytes == 0)
     {
@@ -32,11 +54,6 @@ unique_ptr<const char[]> stream_parser::read(const size_t number_of_bytes)
         throw ios_base::failure("An error occurred while reading from the file.");
     }
 
-    if (_m_should_reverse_bytes)
-    {
-        reverse(&ret[0], &ret[number_of_bytes]);
-    }
-
     return ret;
 }
 
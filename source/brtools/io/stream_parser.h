@@ -31,6 +31,12 @@ namespace io
          */
         void reverse_byte_order();
 
+        /**
+         * Indicates whether multi-byte reads are currently reversed; that is,
+         * whether there was an odd number of calls to reverse_byte_order.
+         */
+        bool byte_order_reversed() const;
+
     public: // read methods
         /**
          * Reads specified number of bytes from stream. Reverses bytes if number_
@@ -45,6 +51,18 @@ namespace io
          */
         std::unique_ptr<const char[]> read(size_t number_of_bytes = 1);
 
+        /**
+         * Reads specified number of bytes from stream as they are, regardless
+         * of byte order. Useful for reading blocks of data to be parsed later.
+         *
+         * @throws std::ios_base::failure
+         *         if the good bit is not set after this read.
+         *
+         * @throws std::invalid_argument
+         *         if number_of_bytes == 0
+         */
+        std::unique_ptr<const char[]> read_raw(size_t number_of_bytes);
+
         /**
          * Reads a value of type Tp from the parser, but doesn't change the reading
          * position of the stream.
@@ -158,6 +176,13 @@ namespace io
          */
         void seek_by_offset_from_base(std::streamoff);
 
+    private:
+        /**
+         * Reads specified number of bytes from stream, in the order they are
+         * in the stream.
+         */
+        std::unique_ptr<char[]> read_bytes(size_t number_of_bytes);
+
     private:
         std::istream&              _m_stream_in;
         bool                       _m_should_reverse_bytes;
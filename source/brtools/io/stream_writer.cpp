@@ -0,0 +1,49 @@
+#include "stream_writer.h"
+#include <algorithm>        // for reverse_copy
+#include <memory>           // for unique_ptr
+
+using namespace brtools::io;
+using namespace std;
+
+stream_writer::stream_writer(ostream& file_out)
+: _m_stream_out(file_out)
+, _m_should_reverse_bytes(false)
+{
+}
+
+void stream_writer::reverse_byte_order()
+{
+    _m_should_reverse_bytes = !_m_should_reverse_bytes;
+}
+
+bool stream_writer::byte_order_reversed() const
+{
+    return _m_should_reverse_bytes;
+}
+
+void stream_writer::write(const char* const bytes, const size_t number_of_bytes)
+{
+    if (_m_should_reverse_bytes && number_of_bytes > 1)
+    {
+        const auto reversed = make_unique<char[]>(number_of_bytes);
+        reverse_copy(bytes, bytes + number_of_bytes, reversed.get());
+        write_raw(reversed.get(), number_of_bytes);
+    }
+    else
+    {
+        write_raw(bytes, number_of_bytes);
+    }
+}
+
+void stream_writer::write_raw(const char* const bytes, const size_t number_of_bytes)
+{
+    if (!_m_stream_out.write(bytes, number_of_bytes))
+    {
+        throw ios_base::failure("An error occurred while writing to the file.");
+    }
+}
+
+streampos stream_writer::tell() const
+{
+    return _m_stream_out.tellp();
+}
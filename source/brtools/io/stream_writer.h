@@ -0,0 +1,91 @@
+#ifndef BRTOOLS_IO_STREAM_WRITER_H
+#define BRTOOLS_IO_STREAM_WRITER_H
+#pragma once
+
+#include <ostream>
+#include <ios>              // std::streampos
+#include <type_traits>      // std::is_integral
+
+namespace brtools
+{
+namespace io
+{
+    /**
+     * Counterpart of stream_parser for writing.
+     */
+    class stream_writer
+    {
+    public:
+        stream_writer(std::ostream&);
+
+        /**
+         * By default, multi-byte values are written in the byte order of the
+         * machine. When this is called, subsequent multi-byte writes are
+         * reversed.
+         *
+         * @see stream_parser::reverse_byte_order
+         */
+        void reverse_byte_order();
+
+        /**
+         * Indicates whether multi-byte writes are currently reversed; that is,
+         * whether there was an odd number of calls to reverse_byte_order.
+         */
+        bool byte_order_reversed() const;
+
+    public: // write methods
+        /**
+         * Writes specified number of bytes to stream. Reverses bytes if there
+         * was a call to stream_writer::reverse_byte_order before.
+         *
+         * @throws std::ios_base::failure
+         *         if the good bit is not set after this write.
+         */
+        void write(const char* bytes, size_t number_of_bytes);
+
+        /**
+         * Writes specified number of bytes to stream as they are, regardless
+         * of byte order.
+         *
+         * @throws std::ios_base::failure
+         *         if the good bit is not set after this write.
+         */
+        void write_raw(const char* bytes, size_t number_of_bytes);
+
+        /**
+         * Writes a value of type Tp. Alias of the stream operator.
+         */
+        template<typename Tp>
+        void write(const Tp& value)
+        {
+            *this << value;
+        }
+
+    public: // position related
+        /**
+         * Retrieves the current stream position being written.
+         */
+        std::streampos tell() const;
+
+    private:
+        std::ostream& _m_stream_out;
+        bool          _m_should_reverse_bytes;
+    };
+
+    /**
+     * Enables use of stream operator like standard ostreams. RHS is typically
+     * an integral value. Note that this operator may be specialized, so RHS is
+     * not required to be an integral type.
+     */
+    template<typename Tp>
+    stream_writer& operator<<(stream_writer& writer, const Tp& value)
+    {
+        static_assert(std::is_integral<Tp>::value,
+                      "Stream operator use for non-integral types "
+                      "must be specialized.");
+        writer.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        return writer;
+    }
+}
+}
+#endif
@@ -0,0 +1,398 @@
+#include <brtools/trie/concurrent_stringtrie.h>
+#include "detail/string_bit_index_type.h"
+#include "detail/string_diff.h"
+
+#include <limits>       // numeric_limits
+#include <memory>       // unique_ptr, make_unique
+#include <stdexcept>    // invalid_argument, out_of_range, length_error
+#include <utility>      // move
+
+using namespace brtools::trie;
+using namespace brtools::trie::detail;
+using namespace std;
+
+using brtools::util::string_ref;
+
+using diff_index_type = string_bit_index_type<uint32_t>;
+
+/**
+ * A branch, or a leaf if id is valid. Nodes are not changed once they are
+ * published.
+ */
+struct concurrent_stringtrie::node
+{
+    /**
+     * Raw value of the first bit where the strings under the children
+     * differ. Unused in leaves.
+     */
+    uint32_t       first_diff_bit_index;
+    string_id_type id;
+    const node*    children[2];
+};
+
+struct concurrent_stringtrie::leaf : concurrent_stringtrie::node
+{
+    std::string str;
+};
+
+struct concurrent_stringtrie::version
+{
+    const node* root;
+    size_t      size;
+};
+
+/**
+ * The epoch a reader has pinned while it holds snapshots, or 0. Slots are
+ * linked into a list that only grows, and are reused by later readers.
+ */
+struct concurrent_stringtrie::reader_slot
+{
+    std::atomic<uint64_t> pinned{ 0 };
+    std::atomic<bool>     in_use{ true };
+
+    /**
+     * The number of snapshots held, only accessed by the reader.
+     */
+    size_t                depth = 0;
+    reader_slot*          next  = nullptr;
+};
+
+/**
+ * A version and the branches it no longer shares with the next one, along
+ * with the epoch they were replaced in.
+ */
+struct concurrent_stringtrie::retired
+{
+    uint64_t                 epoch;
+    const version*           old_version;
+    std::vector<const node*> branches;
+};
+
+namespace
+{
+    /**
+     * Gets the side of the child to traverse to given the string and the
+     * branch. If the bit in string at first_diff_bit_index is 0, the left
+     * child is chosen, otherwise the right child is chosen.
+     */
+    template<typename _Node>
+    bool next_side(const string_ref str, const _Node& node)
+    {
+        return diff_index_type(node.first_diff_bit_index).bit_in(str.data(), str.length());
+    }
+
+    template<typename _Node>
+    bool is_leaf(const _Node* const node)
+    {
+        return node->id != concurrent_stringtrie::invalid;
+    }
+
+    /**
+     * Segment of the id and index of the id in it.
+     */
+    pair<size_t, size_t> locate(const concurrent_stringtrie::string_id_type id, const size_t first_segment_size)
+    {
+        // segment s starts at first_segment_size * (2^s - 1)
+        const auto shifted = uint64_t(id) + first_segment_size;
+        const auto segment = numeric_limits<uint64_t>::digits - 1
+                           - count_leading_zeros_in_word(shifted / first_segment_size);
+        return { segment, shifted - (first_segment_size << segment) };
+    }
+}
+
+
+concurrent_stringtrie::concurrent_stringtrie()
+: _m_version(new version{ nullptr, 0 })
+, _m_epoch(1)
+, _m_readers(nullptr)
+, _m_segments()
+{}
+
+concurrent_stringtrie::~concurrent_stringtrie()
+{
+    for (auto& r : _m_retired)
+    {
+        for (const auto branch : r.branches)
+        {
+            delete branch;
+        }
+        delete r.old_version;
+    }
+
+    // leaves are freed through the segments below
+    const auto current = _m_version.load();
+    vector<const node*> pending;
+    if (current->root != nullptr && !is_leaf(current->root))
+    {
+        pending.push_back(current->root);
+    }
+    while (!pending.empty())
+    {
+        const auto branch = pending.back();
+        pending.pop_back();
+        for (const auto child : branch->children)
+        {
+            if (!is_leaf(child))
+            {
+                pending.push_back(child);
+            }
+        }
+        delete branch;
+    }
+
+    for (string_id_type id = 0; id < current->size; ++id)
+    {
+        delete leaf_at(id);
+    }
+    for (const auto segment : _m_segments)
+    {
+        delete[] segment;
+    }
+    delete current;
+
+    for (auto slot = _m_readers.load(); slot != nullptr; )
+    {
+        const auto next = slot->next;
+        delete slot;
+        slot = next;
+    }
+}
+
+concurrent_stringtrie::string_id_type concurrent_stringtrie::insert(const string_ref str)
+{
+    if (str.length() > diff_index_type::max_string_length)
+    {
+        throw length_error("The string is too long for the trie.");
+    }
+
+    const lock_guard<mutex> lock(_m_writer_mutex);
+
+    const auto current = _m_version.load(memory_order_relaxed);
+    const node* ref = current->root;
+    if (ref != nullptr)
+    {
+        while (!is_leaf(ref))
+        {
+            ref = ref->children[next_side(str, *ref)];
+        }
+    }
+
+    diff_index_type first_diff_bit_index(diff_index_type::max);
+    if (ref != nullptr &&
+        (first_diff_bit_index = find_first_diff_bit_index<uint32_t>(str, static_cast<const leaf*>(ref)->str))
+         == diff_index_type::max)
+    {
+        // already in the trie
+        return ref->id;
+    }
+
+    const auto id = static_cast<string_id_type>(current->size);
+    if (id == invalid)
+    {
+        throw length_error("The trie cannot hold any more strings.");
+    }
+
+    // the leaf is written before the version that reaches it is published
+    const auto location = locate(id, first_segment_size);
+    if (_m_segments[location.first] == nullptr)
+    {
+        _m_segments[location.first] = new const leaf*[first_segment_size << location.first];
+    }
+    auto new_leaf = make_unique<leaf>();
+    new_leaf->first_diff_bit_index = 0;
+    new_leaf->id = id;
+    new_leaf->children[0] = new_leaf->children[1] = nullptr;
+    new_leaf->str = str.str();
+
+    // finds where the new branch goes, as stringtrie::insert does, keeping
+    // the path to copy
+    vector<const node*> path;
+    vector<bool>        sides;
+    const node*         subtrie = current->root;
+    while (subtrie != nullptr && !is_leaf(subtrie) && subtrie->first_diff_bit_index < first_diff_bit_index.index)
+    {
+        path.push_back(subtrie);
+        sides.push_back(next_side(str, *subtrie));
+        subtrie = subtrie->children[sides.back()];
+    }
+
+    vector<unique_ptr<node>> copies;
+    const node* replacement = new_leaf.get();
+    if (subtrie != nullptr)
+    {
+        const auto side = first_diff_bit_index.bit_in(str.data(), str.length());
+        copies.push_back(make_unique<node>(node{ first_diff_bit_index.index, invalid,
+                                                 { side ? subtrie : new_leaf.get(), side ? new_leaf.get() : subtrie } }));
+        replacement = copies.back().get();
+    }
+
+    // copies the path bottom up, each copy pointing to the one below
+    for (auto i = path.size(); i-- > 0; )
+    {
+        copies.push_back(make_unique<node>(*path[i]));
+        copies.back()->children[sides[i]] = replacement;
+        replacement = copies.back().get();
+    }
+
+    auto next = make_unique<version>(version{ replacement, current->size + 1 });
+    _m_retired.push_back(retired{ 0, current, move(path) });
+
+    // nothing below throws
+    _m_segments[location.first][location.second] = new_leaf.release();
+    for (auto& copy : copies)
+    {
+        copy.release();
+    }
+
+    _m_version.store(next.release());
+    _m_retired.back().epoch = _m_epoch.fetch_add(1);
+
+    reclaim();
+    return id;
+}
+
+const concurrent_stringtrie::leaf* concurrent_stringtrie::leaf_at(const string_id_type id) const
+{
+    const auto location = locate(id, first_segment_size);
+    return _m_segments[location.first][location.second];
+}
+
+void concurrent_stringtrie::reclaim()
+{
+    // a reader pinned at an epoch may hold any version replaced since
+    auto oldest_pinned = numeric_limits<uint64_t>::max();
+    for (auto slot = _m_readers.load(); slot != nullptr; slot = slot->next)
+    {
+        const auto pinned = slot->pinned.load();
+        if (pinned != 0 && pinned < oldest_pinned)
+        {
+            oldest_pinned = pinned;
+        }
+    }
+
+    // retired in order of epoch
+    auto it = _m_retired.begin();
+    for (; it != _m_retired.end() && it->epoch < oldest_pinned; ++it)
+    {
+        for (const auto branch : it->branches)
+        {
+            delete branch;
+        }
+        delete it->old_version;
+    }
+    _m_retired.erase(_m_retired.begin(), it);
+}
+
+
+concurrent_stringtrie::reader::reader(const concurrent_stringtrie& trie)
+: _m_trie(trie)
+, _m_slot([&trie]() -> reader_slot&
+  {
+      // reuses a slot left by a destroyed reader, or links in a new one
+      for (auto slot = trie._m_readers.load(); slot != nullptr; slot = slot->next)
+      {
+          auto in_use = false;
+          if (!slot->in_use.load(memory_order_relaxed) &&
+              slot->in_use.compare_exchange_strong(in_use, true, memory_order_acquire))
+          {
+              return *slot;
+          }
+      }
+
+      const auto slot = new reader_slot;
+      slot->next = trie._m_readers.load();
+      while (!trie._m_readers.compare_exchange_weak(slot->next, slot));
+      return *slot;
+  }())
+{}
+
+concurrent_stringtrie::reader::~reader()
+{
+    _m_slot.in_use.store(false, memory_order_release);
+}
+
+concurrent_stringtrie::snapshot concurrent_stringtrie::reader::take_snapshot() const
+{
+    return snapshot(_m_trie, _m_slot);
+}
+
+concurrent_stringtrie::string_id_type concurrent_stringtrie::reader::find_id(const string_ref str) const
+{
+    return take_snapshot().find_id(str);
+}
+
+
+concurrent_stringtrie::snapshot::snapshot(const concurrent_stringtrie& trie, reader_slot& slot)
+: _m_trie(&trie)
+, _m_slot(&slot)
+{
+    // the epoch is pinned before the version is loaded, so a writer that
+    // retires the version afterwards sees the pin; both are sequentially
+    // consistent so that the load is not ordered before the pin
+    if (slot.depth++ == 0)
+    {
+        slot.pinned.store(trie._m_epoch.load());
+    }
+    _m_version = trie._m_version.load();
+}
+
+concurrent_stringtrie::snapshot::snapshot(snapshot&& other) noexcept
+: _m_trie(other._m_trie)
+, _m_slot(other._m_slot)
+, _m_version(other._m_version)
+{
+    other._m_slot = nullptr;
+}
+
+concurrent_stringtrie::snapshot::~snapshot()
+{
+    if (_m_slot != nullptr && --_m_slot->depth == 0)
+    {
+        _m_slot->pinned.store(0, memory_order_release);
+    }
+}
+
+concurrent_stringtrie::string_id_type concurrent_stringtrie::snapshot::find_id(const string_ref str) const
+{
+    const node* ref = _m_version->root;
+    if (ref == nullptr)
+    {
+        return invalid;
+    }
+
+    while (!is_leaf(ref))
+    {
+        ref = ref->children[next_side(str, *ref)];
+    }
+
+    // the leaf only shares the bits tested on the way with str,
+    // so the whole string has to be compared
+    const auto& leaf_str = static_cast<const leaf*>(ref)->str;
+    return string_ref(leaf_str) == str ? ref->id : invalid;
+}
+
+string_ref concurrent_stringtrie::snapshot::find_string_ref(const string_id_type str_id) const
+{
+    if (str_id == invalid)
+    {
+        throw invalid_argument("The given string id is invalid.");
+    }
+    else if (str_id < _m_version->size)
+    {
+        return _m_trie->leaf_at(str_id)->str;
+    }
+    else
+    {
+        throw out_of_range("The given string id does not correspond to any string.");
+    }
+}
+
+string concurrent_stringtrie::snapshot::find_string(const string_id_type str_id) const
+{
+    return find_string_ref(str_id).str();
+}
+
+size_t concurrent_stringtrie::snapshot::size() const
+{
+    return _m_version->size;
+}
@@ -2,7 +2,8 @@
 #define BRTOOLS_TRIE_DETAIL_STRING_BIT_INDEX_TYPE_H
 
 #include <limits>
-#include <cstdint>  // uint16_t
+#include <cstdint>  // uint16_t, uint32_t, uint64_t
+#include <cstddef>  // size_t
 #include <string>
 
 namespace brtools
@@ -36,7 +37,7 @@ namespace detail
          * Mask to keep the least significant first _BitCount-bits of a value.
          * For example, if _BitCount is 3, then truncate_mask is 0b0...00111.
          */
-        static constexpr _RawValueType truncate_mask = static_cast<_RawValueType>(~0u) >> (bits_in_raw_value - _BitCount);
+        static constexpr _RawValueType truncate_mask = static_cast<_RawValueType>(~_RawValueType(0)) >> (bits_in_raw_value - _BitCount);
 
         /**
          * Mask to clear the previously set bits in the raw value, in order to
@@ -44,7 +45,7 @@ namespace detail
          * For example, if _BitCount is 3, _BitShift is 5, then clear_mask is
          * 0b1...1'000'11111.
          */
-        static constexpr _RawValueType clear_mask = ~(truncate_mask << _BitShift);
+        static constexpr _RawValueType clear_mask = static_cast<_RawValueType>(~(truncate_mask << _BitShift));
 
     public:
         explicit bit_field(_RawValueType& raw) : _m_raw(raw) {}
@@ -73,7 +74,12 @@ namespace detail
      * Addresses a bit in a string. Following the string indexing conventions,
      * the leftmost bit is defined to be index 0.
      *
-     * @tparam _IndexType The underlying type that stores the index.
+     * The raw index is the character index times 8 plus the bit index for
+     * every index type, so a raw index that fits in a narrower type has the
+     * same value there.
+     *
+     * @tparam _IndexType The underlying type that stores the index, one of
+     *                    uint16_t, uint32_t and uint64_t.
      */
     template<typename _IndexType>
     struct string_bit_index_type
@@ -98,7 +104,14 @@ namespace detail
 
     public:
         enum : index_type
-        { max = static_cast<index_type>(~0u) };
+        { max = std::numeric_limits<index_type>::max() };
+
+        /**
+         * The length of the longest strings whose bits can all be addressed.
+         * The last character index is left out, since its last bit is the
+         * max value.
+         */
+        static constexpr size_t max_string_length = char_index_type::truncate_mask;
 
         /**
          * The bit index in the string.
@@ -189,7 +202,16 @@ namespace detail
          */
         bool operator[](const std::string& str) const
         {
-            if (char_index >= str.length())
+            return bit_in(str.data(), str.length());
+        }
+
+        /**
+         * @returns The bit of the length characters starting at str at the
+         *          specified index, or 0 if index is past the end of them.
+         */
+        bool bit_in(const char* const str, const size_t length) const
+        {
+            if (char_index >= length)
             {
                 // treat the str as if there were a stream of NUL past the end
                 return 0;
@@ -0,0 +1,102 @@
+#ifndef BRTOOLS_TRIE_DETAIL_STRING_DIFF_H
+#define BRTOOLS_TRIE_DETAIL_STRING_DIFF_H
+#pragma once
+
+#include <limits>       // numeric_limits
+#include <algorithm>    // min, max
+#include <cstdint>      // uint16_t, uint64_t
+#include <cstddef>      // size_t
+#include <cstring>      // memcpy
+
+#include <brtools/util/string_ref.h>
+#include "string_bit_index_type.h"
+
+namespace brtools
+{
+namespace trie
+{
+namespace detail
+{
+    /**
+     * Finds the index of first occurrence of 1 in the given argument. Behavior
+     * is only defined if num is not 0, and _Tp is an unsigned integral type.
+     */
+    template<typename _Tp>
+    constexpr size_t count_leading_zeros(const _Tp num)
+    {
+        return 1 == num >> (std::numeric_limits<_Tp>::digits - 1) ? 0 : 1 + count_leading_zeros<_Tp>(num << 1);
+    }
+
+    /**
+     * count_leading_zeros for words, using the instruction where available.
+     * Behavior is only defined if word is not 0.
+     */
+    inline size_t count_leading_zeros_in_word(const uint64_t word)
+    {
+    #if defined(__GNUC__)
+        return __builtin_clzll(word);
+    #else
+        return count_leading_zeros(word);
+    #endif
+    }
+
+    /**
+     * Loads the up to 8 characters of str starting at position as a word, with
+     * the first character in the most significant byte, so that the bits of
+     * the word are in the order of string_bit_index_type. Characters past the
+     * end of str are loaded as NUL.
+     */
+    inline uint64_t load_word(const util::string_ref str, const size_t position)
+    {
+        unsigned char bytes[sizeof(uint64_t)] = {};
+        if (position < str.length())
+        {
+            std::memcpy(bytes, str.data() + position, std::min(sizeof(bytes), str.length() - position));
+        }
+
+        // compiles to a single byte-swapping load where applicable
+        uint64_t word = 0;
+        for (const auto byte : bytes)
+        {
+            word = word << std::numeric_limits<unsigned char>::digits | byte;
+        }
+        return word;
+    }
+
+    /**
+     * Finds the bit index of the first bit where the two given strings differ.
+     * The strings are compared a word at a time.
+     *
+     * If the length of the two strings differ, then the diff bit is the first
+     * 1 bit in the longer string.
+     *
+     * If the two strings are completely identical, then there is no diff bit
+     * and the result is the max value.
+     *
+     * If either str1 or str2 or both contain the NUL char, the behavior is
+     * not defined. Neither string may be longer than the max_string_length
+     * of the index type.
+     */
+    template<typename _IndexType>
+    string_bit_index_type<_IndexType> find_first_diff_bit_index(const util::string_ref str1,
+                                                                const util::string_ref str2)
+    {
+        const auto length = std::max(str1.length(), str2.length());
+        for (size_t position = 0; position < length; position += sizeof(uint64_t))
+        {
+            if (const auto diff = load_word(str1, position) ^ load_word(str2, position))
+            {
+                const auto bit = count_leading_zeros_in_word(diff);
+
+                string_bit_index_type<_IndexType> result;
+                result.char_index = position + bit / std::numeric_limits<unsigned char>::digits;
+                result.bit_index  = bit % std::numeric_limits<unsigned char>::digits;
+                return result;
+            }
+        }
+        return string_bit_index_type<_IndexType>(string_bit_index_type<_IndexType>::max);
+    }
+}
+}
+}
+#endif
@@ -0,0 +1,160 @@
+#ifndef BRTOOLS_TRIE_DETAIL_STRING_POOL_H
+#define BRTOOLS_TRIE_DETAIL_STRING_POOL_H
+#pragma once
+
+#include <cstdint>      // uint32_t
+#include <cstddef>      // size_t
+#include <limits>       // numeric_limits
+#include <stdexcept>    // length_error
+#include <vector>
+
+#include <brtools/trie/stringtrie.h>
+#include <brtools/util/string_ref.h>
+
+namespace brtools
+{
+namespace trie
+{
+namespace detail
+{
+    /**
+     * Stores the strings of a stringtrie back to back in a single character
+     * buffer, located by a table indexed directly by string id.
+     */
+    class string_pool
+    {
+    public:
+        using string_id_type = stringtrie::string_id_type;
+
+        /**
+         * Stores str under id, which must not have a string yet.
+         *
+         * @throws std::length_error if the pool would exceed 4 GiB.
+         */
+        void add(const string_id_type id, const util::string_ref str)
+        {
+            if (str.length() > max_offset - _m_chars.size())
+            {
+                throw std::length_error("The string pool cannot hold any more characters.");
+            }
+
+            if (id >= _m_entries.size())
+            {
+                _m_entries.resize(id + 1, entry{ absent, 0 });
+            }
+            _m_entries[id] = entry{ static_cast<uint32_t>(_m_chars.size()), static_cast<uint32_t>(str.length()) };
+            _m_chars.insert(_m_chars.end(), str.begin(), str.end());
+        }
+
+        /**
+         * Removes the string stored under id, which must have one. The
+         * characters are left in place until at least as many belong to
+         * removed strings as to stored ones, and the pool is then compacted,
+         * so that each character is moved a bounded number of times.
+         */
+        void remove(const string_id_type id)
+        {
+            _m_garbage += _m_entries[id].length;
+            _m_entries[id].offset = absent;
+            while (!_m_entries.empty() && _m_entries.back().offset == absent)
+            {
+                _m_entries.pop_back();
+            }
+
+            if (_m_entries.empty())
+            {
+                std::vector<char>().swap(_m_chars);
+                std::vector<entry>().swap(_m_entries);
+                _m_garbage = 0;
+            }
+            else if (_m_garbage >= _m_chars.size() - _m_garbage)
+            {
+                compact();
+            }
+        }
+
+        /**
+         * One past the largest id that has a string, or 0 if there is none.
+         */
+        string_id_type id_count() const
+        {
+            return static_cast<string_id_type>(_m_entries.size());
+        }
+
+        /**
+         * Whether a string is stored under id.
+         */
+        bool contains(const string_id_type id) const
+        {
+            return id < _m_entries.size() && _m_entries[id].offset != absent;
+        }
+
+        /**
+         * The string stored under id, which must have one. The reference is
+         * valid until the next call to add or remove.
+         */
+        util::string_ref operator[](const string_id_type id) const
+        {
+            const auto& e = _m_entries[id];
+            return util::string_ref(_m_chars.data() + e.offset, e.length);
+        }
+
+        /**
+         * Hints the processor to start loading the string stored under id,
+         * which must have one.
+         */
+        void prefetch(const string_id_type id) const
+        {
+        #if defined(__GNUC__)
+            __builtin_prefetch(_m_chars.data() + _m_entries[id].offset);
+        #else
+            static_cast<void>(id);
+        #endif
+        }
+
+    private:
+        struct entry
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        /**
+         * Moves the stored strings to the front of a buffer without the
+         * characters of removed strings.
+         */
+        void compact()
+        {
+            std::vector<char> chars;
+            chars.reserve(_m_chars.size() - _m_garbage);
+            for (auto& e : _m_entries)
+            {
+                if (e.offset != absent)
+                {
+                    const auto offset = static_cast<uint32_t>(chars.size());
+                    chars.insert(chars.end(), _m_chars.cbegin() + e.offset, _m_chars.cbegin() + e.offset + e.length);
+                    e.offset = offset;
+                }
+            }
+            _m_chars.swap(chars);
+            _m_garbage = 0;
+        }
+
+        /**
+         * Offset of ids without a string.
+         */
+        static constexpr uint32_t absent     = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t max_offset = absent - 1;
+
+        std::vector<char>  _m_chars;
+        std::vector<entry> _m_entries;
+
+        /**
+         * Number of characters in _m_chars that belong to removed strings.
+         */
+        size_t             _m_garbage = 0;
+    };
+}
+}
+}
+#endif
@@ -0,0 +1,57 @@
+#ifndef BRTOOLS_TRIE_DETAIL_SYMB_FORMAT_H
+#define BRTOOLS_TRIE_DETAIL_SYMB_FORMAT_H
+#pragma once
+
+#include <cstdint>  // uint16_t, uint32_t
+#include <cstddef>  // size_t
+
+namespace brtools
+{
+namespace trie
+{
+namespace detail
+{
+    /**
+     * Layout of the Patricia trees in BR SYMB blocks.
+     *
+     * A string table is a u32 count followed by that many u32 offsets to
+     * NUL-terminated strings. A tree is a u32 root node index and a u32 node
+     * count, followed by that many nodes of
+     *
+     *     u16 flags               leaf_flag for leaves
+     *     u16 bit index           raw value of string_bit_index_type<uint16_t>
+     *     u32 left node index     taken if the bit is 0
+     *     u32 right node index    taken if the bit is 1
+     *     u32 string id           index in the string table
+     *     u32 item id
+     *
+     * Offsets are relative to the start of the SYMB block data. All values
+     * are big endian in BR files.
+     */
+    namespace symb_format
+    {
+        constexpr size_t header_size        = 0x08;    // string table and tree offsets
+        constexpr size_t string_table_entry = 0x04;
+        constexpr size_t tree_header_size   = 0x08;    // root index and node count
+        constexpr size_t node_size          = 0x14;
+
+        constexpr size_t flags_offset       = 0x00;
+        constexpr size_t bit_offset         = 0x02;
+        constexpr size_t left_offset        = 0x04;
+        constexpr size_t right_offset       = 0x08;
+        constexpr size_t string_id_offset   = 0x0C;
+        constexpr size_t item_id_offset     = 0x10;
+
+        constexpr uint16_t leaf_flag        = 0x0001;
+
+        /**
+         * Stands for indices and ids that do not apply, such as the children
+         * of leaves, and the root of an empty tree.
+         */
+        constexpr uint32_t no_index         = 0xFFFFFFFF;
+        constexpr uint16_t no_bit           = 0xFFFF;
+    }
+}
+}
+}
+#endif
@@ -0,0 +1,152 @@
+#ifndef BRTOOLS_TRIE_DETAIL_TRIE_NODE_POOL_H
+#define BRTOOLS_TRIE_DETAIL_TRIE_NODE_POOL_H
+#pragma once
+
+#include <cstdint>  // uint32_t
+#include <vector>
+
+#include <brtools/trie/stringtrie.h>
+
+namespace brtools
+{
+namespace trie
+{
+namespace detail
+{
+    /**
+     * Branch node of a stringtrie. Leaves are not stored as nodes; a child
+     * reference to a leaf holds the string id of the leaf instead.
+     */
+    struct trie_node
+    {
+        using node_ref = uint32_t;
+
+        /**
+         * Raw value of the string_bit_index_type<uint32_t> of the first bit
+         * where the strings under the left and right children differ. It is
+         * as wide as the children, so the node is no larger than with a
+         * 16-bit index, which would limit keys to 8 KiB.
+         */
+        uint32_t first_diff_bit_index;
+
+        /**
+         * The children chosen when the bit at first_diff_bit_index is 0 and
+         * 1 respectively.
+         */
+        node_ref children[2];
+    };
+
+    static_assert(sizeof(trie_node) == 3 * sizeof(uint32_t), "Branch nodes are expected to be unpadded.");
+
+    /**
+     * Stores the branch nodes of a stringtrie contiguously. Nodes refer to each other by their index in the pool, so
+     * a lookup walks a single array instead of chasing pointers.
+     */
+    class trie_node_pool
+    {
+    public:
+        using node_ref = trie_node::node_ref;
+
+        /**
+         * Set in references to leaves. The remaining bits hold the string id.
+         */
+        static constexpr node_ref leaf_flag = node_ref(1) << 31;
+
+        /**
+         * Refers to nothing, such as the root of an empty trie.
+         */
+        static constexpr node_ref null_ref = static_cast<node_ref>(~0u);
+
+        /**
+         * Largest string id that can be referred to.
+         */
+        static constexpr stringtrie::string_id_type max_id = null_ref - leaf_flag - 1;
+
+        static bool is_leaf(const node_ref ref)
+        {   return (ref & leaf_flag) != 0;   }
+
+        static node_ref leaf_ref(const stringtrie::string_id_type id)
+        {   return leaf_flag | id;   }
+
+        static stringtrie::string_id_type leaf_id(const node_ref ref)
+        {   return ref & ~leaf_flag;   }
+
+        /**
+         * Adds a branch node to the pool, in the slot of a removed node if
+         * there is one, and appended otherwise.
+         *
+         * @return Reference to the new node. References to existing nodes
+         *         remain valid, but pointers and references into the pool
+         *         do not.
+         */
+        node_ref add(const uint32_t first_diff_bit_index, const node_ref left, const node_ref right)
+        {
+            if (_m_free != null_ref)
+            {
+                const auto ref = _m_free;
+                _m_free = _m_nodes[ref].children[0];
+                _m_nodes[ref] = { first_diff_bit_index, { left, right } };
+                return ref;
+            }
+            _m_nodes.push_back({ first_diff_bit_index, { left, right } });
+            return static_cast<node_ref>(_m_nodes.size() - 1);
+        }
+
+        /**
+         * Removes a branch node, which must no longer be referred to. Its slot
+         * is kept for the next node added, so that a pool under churn does
+         * not grow beyond its largest size.
+         */
+        void remove(const node_ref ref)
+        {
+            _m_nodes[ref].children[0] = _m_free;
+            _m_free = ref;
+        }
+
+        /**
+         * Removes all nodes and releases their memory.
+         */
+        void clear()
+        {
+            std::vector<trie_node>().swap(_m_nodes);
+            _m_free = null_ref;
+            root    = null_ref;
+        }
+
+        /**
+         * Hints the processor to start loading the node, so that it is in
+         * cache by the time it is accessed.
+         */
+        void prefetch(const node_ref ref) const
+        {
+        #if defined(__GNUC__)
+            __builtin_prefetch(_m_nodes.data() + ref);
+        #else
+            static_cast<void>(ref);
+        #endif
+        }
+
+        trie_node& operator[](const node_ref ref)
+        {   return _m_nodes[ref];   }
+
+        const trie_node& operator[](const node_ref ref) const
+        {   return _m_nodes[ref];   }
+
+        /**
+         * The root of the trie, which is a leaf if the trie has one string.
+         */
+        node_ref root = null_ref;
+
+    private:
+        std::vector<trie_node> _m_nodes;
+
+        /**
+         * The most recently removed node, whose left child links to the one
+         * removed before, and so on.
+         */
+        node_ref               _m_free = null_ref;
+    };
+}
+}
+}
+#endif
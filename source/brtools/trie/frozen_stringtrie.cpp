@@ -0,0 +1,612 @@
+#include <brtools/trie/frozen_stringtrie.h>
+#include <brtools/error/integrity_error.h>
+#include "detail/string_bit_index_type.h"
+#include "detail/string_pool.h"
+#include "detail/trie_node_pool.h"
+
+#include <algorithm>    // min, max
+#include <cstdint>      // uint32_t, uint64_t, uintptr_t
+#include <cstring>      // memcpy, memcmp
+#include <limits>       // numeric_limits
+#include <stdexcept>    // invalid_argument, out_of_range
+
+using namespace brtools::trie;
+using namespace brtools::trie::detail;
+using namespace std;
+
+using brtools::error::integrity_error;
+using brtools::util::string_ref;
+
+/**
+ * Starts the buffer. Sections follow at the given offsets, aligned to words.
+ */
+struct frozen_stringtrie::header
+{
+    char     magic[4];
+    uint32_t byte_order_mark;
+
+    uint32_t key_count;
+    uint32_t id_count;
+    uint32_t node_count;
+    uint32_t bucket_count;
+
+    uint32_t bit_index_width;
+    uint32_t id_width;
+    uint32_t rank_width;
+    uint32_t reserved;
+
+    uint64_t topology;          // one bit per node in level order, set for branches
+    uint64_t rank_directory;    // u32 count of set bits before each topology word
+    uint64_t bit_indices;       // per branch in level order
+    uint64_t leaf_ids;          // per leaf in level order
+    uint64_t sorted_ranks;      // per id, key_count if there is no string
+    uint64_t bucket_offsets;    // u64 offset in strings of every 16th string in sorted order
+    uint64_t strings;           // front-coded strings in sorted order
+    uint64_t size;
+};
+
+namespace
+{
+    constexpr char     frozen_magic[4] = { 'B', 'R', 'F', 'T' };
+    constexpr uint32_t byte_order_mark = 0x01020304;
+
+    /**
+     * Number of strings front-coded against their predecessor after a
+     * string stored in full.
+     */
+    constexpr size_t bucket_size = 16;
+
+    constexpr size_t word_bits = numeric_limits<uint64_t>::digits;
+
+    /**
+     * The number of units of the given size that count items take, rounded up.
+     * Unlike words_for_bits and words_for_bytes, it does not overflow for
+     * counts read from a file.
+     */
+    uint64_t words_for(const uint64_t count, const uint64_t unit)
+    {
+        return count / unit + (count % unit != 0);
+    }
+
+    size_t words_for_bits(const size_t bits)
+    {
+        return (bits + word_bits - 1) / word_bits;
+    }
+
+    size_t words_for_bytes(const size_t bytes)
+    {
+        return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    }
+
+    /**
+     * The number of bits needed to store values up to max_value; at least 1.
+     */
+    uint32_t bit_width(uint64_t max_value)
+    {
+        uint32_t width = 1;
+        while (max_value >>= 1)
+        {
+            ++width;
+        }
+        return width;
+    }
+
+    size_t popcount(const uint64_t word)
+    {
+    #if defined(__GNUC__)
+        return __builtin_popcountll(word);
+    #else
+        size_t count = 0;
+        for (auto w = word; w != 0; w &= w - 1)
+        {
+            ++count;
+        }
+        return count;
+    #endif
+    }
+
+    /**
+     * Stores value in the index-th slot of width bits. The slots must be
+     * zero before, and words must have a word past the last slot.
+     */
+    void pack(uint64_t* const words, const size_t index, const size_t width, const uint64_t value)
+    {
+        const auto bit   = index * width;
+        const auto shift = bit % word_bits;
+        words[bit / word_bits] |= value << shift;
+        if (shift + width > word_bits)
+        {
+            words[bit / word_bits + 1] |= value >> (word_bits - shift);
+        }
+    }
+
+    uint64_t unpack(const uint64_t* const words, const size_t index, const size_t width)
+    {
+        const auto bit   = index * width;
+        const auto shift = bit % word_bits;
+        auto value = words[bit / word_bits] >> shift;
+        if (shift + width > word_bits)
+        {
+            value |= words[bit / word_bits + 1] << (word_bits - shift);
+        }
+        return value & (numeric_limits<uint64_t>::max() >> (word_bits - width));
+    }
+
+    void write_varint(vector<char>& bytes, size_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+        {
+            bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    size_t read_varint(const char*& bytes)
+    {
+        size_t value = 0;
+        for (size_t shift = 0;; shift += 7)
+        {
+            const auto byte = static_cast<unsigned char>(*bytes++);
+            value |= size_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+    }
+}
+
+frozen_stringtrie::frozen_stringtrie(const stringtrie& trie)
+{
+    const auto& nodes   = *trie._m_nodes;
+    const auto& strings = *trie._m_strings;
+
+    // leaves from left to right, which is the sorted order of the strings
+    vector<string_id_type> sorted_ids;
+    if (nodes.root != trie_node_pool::null_ref)
+    {
+        vector<trie_node_pool::node_ref> pending{ nodes.root };
+        while (!pending.empty())
+        {
+            const auto ref = pending.back();
+            pending.pop_back();
+            if (trie_node_pool::is_leaf(ref))
+            {
+                sorted_ids.push_back(trie_node_pool::leaf_id(ref));
+            }
+            else
+            {
+                pending.push_back(nodes[ref].children[1]);
+                pending.push_back(nodes[ref].children[0]);
+            }
+        }
+    }
+
+    // nodes in level order
+    vector<trie_node_pool::node_ref> level_order;
+    if (nodes.root != trie_node_pool::null_ref)
+    {
+        level_order.push_back(nodes.root);
+    }
+    for (size_t i = 0; i < level_order.size(); ++i)
+    {
+        if (!trie_node_pool::is_leaf(level_order[i]))
+        {
+            level_order.push_back(nodes[level_order[i]].children[0]);
+            level_order.push_back(nodes[level_order[i]].children[1]);
+        }
+    }
+
+    // front-coded strings
+    vector<char>     string_bytes;
+    vector<uint64_t> bucket_offsets;
+    for (size_t rank = 0; rank < sorted_ids.size(); ++rank)
+    {
+        const auto str = strings[sorted_ids[rank]];
+        size_t common = 0;
+        if (rank % bucket_size == 0)
+        {
+            bucket_offsets.push_back(string_bytes.size());
+        }
+        else
+        {
+            const auto previous = strings[sorted_ids[rank - 1]];
+            const auto limit = min(str.length(), previous.length());
+            while (common < limit && str[common] == previous[common])
+            {
+                ++common;
+            }
+            write_varint(string_bytes, common);
+        }
+        write_varint(string_bytes, str.length() - common);
+        string_bytes.insert(string_bytes.end(), str.begin() + common, str.end());
+    }
+
+    header h{};
+    memcpy(h.magic, frozen_magic, sizeof(h.magic));
+    h.byte_order_mark = byte_order_mark;
+    h.key_count       = static_cast<uint32_t>(sorted_ids.size());
+    h.id_count        = strings.id_count();
+    h.node_count      = static_cast<uint32_t>(level_order.size());
+    h.bucket_count    = static_cast<uint32_t>(bucket_offsets.size());
+    h.id_width        = bit_width(h.id_count);
+    h.rank_width      = bit_width(h.key_count);
+
+    uint32_t max_bit_index = 0;
+    for (const auto ref : level_order)
+    {
+        if (!trie_node_pool::is_leaf(ref))
+        {
+            max_bit_index = max(max_bit_index, nodes[ref].first_diff_bit_index);
+        }
+    }
+    h.bit_index_width = bit_width(max_bit_index);
+
+    // sections in words, each with a spare word for unpacking
+    const auto branch_count = h.node_count / 2;
+    size_t words = words_for_bytes(sizeof(header));
+    const auto allocate = [&words](const size_t section_words)
+    {
+        const auto offset = words * sizeof(uint64_t);
+        words += section_words + 1;
+        return offset;
+    };
+    const auto topology_words = words_for_bits(h.node_count);
+    h.topology       = allocate(topology_words);
+    h.rank_directory = allocate(words_for_bytes(topology_words * sizeof(uint32_t)));
+    h.bit_indices    = allocate(words_for_bits(branch_count * h.bit_index_width));
+    h.leaf_ids       = allocate(words_for_bits(h.key_count * h.id_width));
+    h.sorted_ranks   = allocate(words_for_bits(size_t(h.id_count) * h.rank_width));
+    h.bucket_offsets = allocate(bucket_offsets.size());
+    h.strings        = allocate(words_for_bytes(string_bytes.size()));
+    h.size           = words * sizeof(uint64_t);
+
+    _m_storage.assign(words, 0);
+    const auto base = _m_storage.data();
+    memcpy(base, &h, sizeof(h));
+
+    const auto topology = base + h.topology / sizeof(uint64_t);
+    size_t branches = 0, leaves = 0;
+    for (size_t i = 0; i < level_order.size(); ++i)
+    {
+        const auto ref = level_order[i];
+        if (trie_node_pool::is_leaf(ref))
+        {
+            pack(base + h.leaf_ids / sizeof(uint64_t), leaves++, h.id_width, trie_node_pool::leaf_id(ref));
+        }
+        else
+        {
+            topology[i / word_bits] |= uint64_t(1) << (i % word_bits);
+            pack(base + h.bit_indices / sizeof(uint64_t), branches++, h.bit_index_width, nodes[ref].first_diff_bit_index);
+        }
+    }
+
+    const auto rank_directory = reinterpret_cast<uint32_t*>(base + h.rank_directory / sizeof(uint64_t));
+    uint32_t ones = 0;
+    for (size_t w = 0; w < topology_words; ++w)
+    {
+        rank_directory[w] = ones;
+        ones += static_cast<uint32_t>(popcount(topology[w]));
+    }
+
+    vector<uint32_t> sorted_ranks(h.id_count, h.key_count);
+    for (size_t rank = 0; rank < sorted_ids.size(); ++rank)
+    {
+        sorted_ranks[sorted_ids[rank]] = static_cast<uint32_t>(rank);
+    }
+    for (string_id_type id = 0; id < h.id_count; ++id)
+    {
+        pack(base + h.sorted_ranks / sizeof(uint64_t), id, h.rank_width, sorted_ranks[id]);
+    }
+
+    if (!bucket_offsets.empty())
+    {
+        memcpy(base + h.bucket_offsets / sizeof(uint64_t), bucket_offsets.data(), bucket_offsets.size() * sizeof(uint64_t));
+    }
+    if (!string_bytes.empty())
+    {
+        memcpy(base + h.strings / sizeof(uint64_t), string_bytes.data(), string_bytes.size());
+    }
+
+    _m_data = reinterpret_cast<const char*>(base);
+    _m_size = h.size;
+}
+
+frozen_stringtrie::frozen_stringtrie(const char* const data, const size_t size)
+: _m_data(data)
+, _m_size(size)
+{
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+    {
+        throw invalid_argument("The frozen trie data is not aligned.");
+    }
+    if (size < sizeof(header))
+    {
+        throw integrity_error("The frozen trie data is too short.");
+    }
+
+    const auto& h = get_header();
+    if (memcmp(h.magic, frozen_magic, sizeof(h.magic)) != 0)
+    {
+        throw integrity_error("The data is not a frozen trie.");
+    }
+    if (h.byte_order_mark != byte_order_mark)
+    {
+        throw integrity_error("The frozen trie was built on a machine of another byte order.");
+    }
+    if (h.size > size)
+    {
+        throw integrity_error("The frozen trie data is truncated.");
+    }
+    for (const auto width : { h.bit_index_width, h.id_width, h.rank_width })
+    {
+        if (width == 0 || width > word_bits)
+        {
+            throw integrity_error("A field width of the frozen trie is out of range.");
+        }
+    }
+
+    // a trie of n keys has n leaves and n - 1 branches
+    const uint64_t branch_count = h.node_count / 2;
+    if (h.node_count % 2 == 0 ? h.node_count != 0 || h.key_count != 0 : h.key_count != branch_count + 1)
+    {
+        throw integrity_error("The node count of the frozen trie does not match its key count.");
+    }
+    if (h.key_count > h.id_count || h.bucket_count != words_for(h.key_count, bucket_size))
+    {
+        throw integrity_error("The counts in the frozen trie header do not match.");
+    }
+
+    // each section has to hold what the header says it does,
+    // and end before the next one starts
+    const uint64_t topology_words = words_for(h.node_count, word_bits);
+    const struct
+    {
+        uint64_t offset;
+        uint64_t words;
+    } sections[] =
+    {
+        { h.topology,       topology_words },
+        { h.rank_directory, words_for(topology_words * sizeof(uint32_t), sizeof(uint64_t)) },
+        { h.bit_indices,    words_for(branch_count * h.bit_index_width, word_bits) },
+        { h.leaf_ids,       words_for(uint64_t(h.key_count) * h.id_width, word_bits) },
+        { h.sorted_ranks,   words_for(uint64_t(h.id_count) * h.rank_width, word_bits) },
+        { h.bucket_offsets, h.bucket_count },
+        { h.strings,        0 },
+    };
+    auto end = uint64_t(words_for(sizeof(header), sizeof(uint64_t))) * sizeof(uint64_t);
+    for (const auto& section : sections)
+    {
+        if (section.offset % sizeof(uint64_t) != 0 || section.offset < end ||
+            section.offset > h.size || section.words > (h.size - section.offset) / sizeof(uint64_t))
+        {
+            throw integrity_error("The frozen trie data is truncated.");
+        }
+        end = section.offset + section.words * sizeof(uint64_t);
+    }
+
+    check_topology();
+    check_strings();
+}
+
+void frozen_stringtrie::check_topology() const
+{
+    // the children of a branch come after it in level order, so that walking
+    // down always ends, and the rank directory counts the branches before
+    // each word, so that the children are never past the last node
+    const auto& h = get_header();
+    const auto topology       = section(h.topology);
+    const auto rank_directory = reinterpret_cast<const uint32_t*>(section(h.rank_directory));
+
+    uint64_t branches = 0;
+    for (uint64_t w = 0; w < words_for(h.node_count, word_bits); ++w)
+    {
+        if (rank_directory[w] != branches)
+        {
+            throw integrity_error("The rank directory of the frozen trie is corrupt.");
+        }
+
+        auto word = topology[w];
+        const auto nodes_in_word = min<uint64_t>(word_bits, h.node_count - w * word_bits);
+        if (nodes_in_word < word_bits && (word >> nodes_in_word) != 0)
+        {
+            throw integrity_error("The topology of the frozen trie is corrupt.");
+        }
+        for (; word != 0; word &= word - 1)
+        {
+            const auto node = w * word_bits + popcount((word & (~word + 1)) - 1);
+            if (2 * branches + 1 <= node)
+            {
+                throw integrity_error("The topology of the frozen trie is corrupt.");
+            }
+            ++branches;
+        }
+    }
+    if (branches != h.node_count / 2)
+    {
+        throw integrity_error("The topology of the frozen trie is corrupt.");
+    }
+}
+
+void frozen_stringtrie::check_strings() const
+{
+    // every string has to be decoded from the bytes of the strings section,
+    // sharing no more characters with its predecessor than it has
+    const auto& h = get_header();
+    const auto strings = reinterpret_cast<const char*>(section(h.strings));
+    const auto length  = h.size - h.strings;
+    const auto bucket_offsets = section(h.bucket_offsets);
+
+    const auto read = [&](uint64_t& position)
+    {
+        uint64_t value = 0;
+        for (size_t shift = 0;; shift += 7)
+        {
+            if (position >= length || shift >= word_bits)
+            {
+                throw integrity_error("The strings of the frozen trie are corrupt.");
+            }
+            const auto byte = static_cast<unsigned char>(strings[position++]);
+            value |= uint64_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+    };
+
+    for (uint64_t rank = 0; rank < h.key_count; rank += bucket_size)
+    {
+        auto position = bucket_offsets[rank / bucket_size];
+        uint64_t previous = 0;
+        for (uint64_t i = 0; i < bucket_size && rank + i < h.key_count; ++i)
+        {
+            const auto common = i == 0 ? 0 : read(position);
+            const auto suffix = read(position);
+            if (common > previous || position > length || suffix > length - position)
+            {
+                throw integrity_error("The strings of the frozen trie are corrupt.");
+            }
+            position += suffix;
+            previous  = common + suffix;
+        }
+    }
+}
+
+frozen_stringtrie::string_id_type frozen_stringtrie::find_id(const string_ref str) const
+{
+    const auto& h = get_header();
+    if (h.node_count == 0)
+    {
+        return invalid;
+    }
+
+    // the children of the k-th branch in level order are nodes 2k+1 and 2k+2
+    const auto bit_indices = section(h.bit_indices);
+    size_t node = 0;
+    while (is_branch(node))
+    {
+        const auto branch = rank_of_branches(node);
+        const auto bit_index = static_cast<uint32_t>(unpack(bit_indices, branch, h.bit_index_width));
+        node = 2 * branch + 1 + string_bit_index_type<uint32_t>(bit_index).bit_in(str.data(), str.length());
+    }
+
+    // the leaf only shares the bits tested on the way with str,
+    // so the whole string has to be compared
+    const auto leaf = node - rank_of_branches(node);
+    const auto id = static_cast<string_id_type>(unpack(section(h.leaf_ids), leaf, h.id_width));
+    return sorted_string_equals(sorted_rank(id), str) ? id : invalid;
+}
+
+string frozen_stringtrie::find_string(const string_id_type str_id) const
+{
+    if (str_id == invalid)
+    {
+        throw invalid_argument("The given string id is invalid.");
+    }
+
+    const auto rank = sorted_rank(str_id);
+    if (rank >= size())
+    {
+        throw out_of_range("The given string id does not correspond to any string.");
+    }
+
+    const auto& h = get_header();
+    auto bytes = reinterpret_cast<const char*>(section(h.strings)) + section(h.bucket_offsets)[rank / bucket_size];
+
+    string result;
+    for (size_t i = 0; i <= rank % bucket_size; ++i)
+    {
+        const auto common = i == 0 ? 0 : read_varint(bytes);
+        const auto length = read_varint(bytes);
+        result.resize(common);
+        result.append(bytes, length);
+        bytes += length;
+    }
+    return result;
+}
+
+size_t frozen_stringtrie::size() const
+{
+    return get_header().key_count;
+}
+
+const char* frozen_stringtrie::data() const
+{
+    return _m_data;
+}
+
+size_t frozen_stringtrie::data_size() const
+{
+    return _m_size;
+}
+
+double frozen_stringtrie::bytes_per_key() const
+{
+    return size() == 0 ? 0 : double(_m_size) / size();
+}
+
+const frozen_stringtrie::header& frozen_stringtrie::get_header() const
+{
+    return *reinterpret_cast<const header*>(_m_data);
+}
+
+const uint64_t* frozen_stringtrie::section(const uint64_t offset) const
+{
+    return reinterpret_cast<const uint64_t*>(_m_data + offset);
+}
+
+bool frozen_stringtrie::is_branch(const size_t node) const
+{
+    return (section(get_header().topology)[node / word_bits] >> (node % word_bits)) & 1;
+}
+
+size_t frozen_stringtrie::rank_of_branches(const size_t node) const
+{
+    const auto& h = get_header();
+    const auto word = section(h.topology)[node / word_bits];
+    const auto mask = (uint64_t(1) << (node % word_bits)) - 1;
+    return reinterpret_cast<const uint32_t*>(section(h.rank_directory))[node / word_bits] + popcount(word & mask);
+}
+
+size_t frozen_stringtrie::sorted_rank(const string_id_type str_id) const
+{
+    const auto& h = get_header();
+    return str_id < h.id_count ? unpack(section(h.sorted_ranks), str_id, h.rank_width) : h.key_count;
+}
+
+bool frozen_stringtrie::sorted_string_equals(const size_t rank, const string_ref str) const
+{
+    if (rank >= size())
+    {
+        return false;
+    }
+
+    const auto& h = get_header();
+    auto bytes = reinterpret_cast<const char*>(section(h.strings)) + section(h.bucket_offsets)[rank / bucket_size];
+
+    // the length of the common prefix of str and the string decoded so far
+    size_t matched = 0;
+    size_t length  = 0;
+    for (size_t i = 0; i <= rank % bucket_size; ++i)
+    {
+        const auto common = i == 0 ? 0 : read_varint(bytes);
+        const auto suffix = read_varint(bytes);
+
+        // the decoded string keeps its first common characters from the
+        // previous one; if they include the first mismatch with str, so does
+        // the decoded string, otherwise matching goes on into the suffix
+        if (common <= matched)
+        {
+            matched = common;
+            while (matched < str.length() && matched - common < suffix && str[matched] == bytes[matched - common])
+            {
+                ++matched;
+            }
+        }
+
+        length = common + suffix;
+        bytes += suffix;
+    }
+    return matched == str.length() && length == str.length();
+}
@@ -1,295 +1,432 @@
 #include <brtools/trie/stringtrie.h>
 #include "detail/string_bit_index_type.h"
+#include "detail/string_diff.h"
+#include "detail/string_pool.h"
+#include "detail/trie_node_pool.h"
 
-#include <functional>   // reference_wrapper, ref
 #include <limits>       // numeric_limits
-#include <tuple>        // tuple, tie, ignore
-#include <stdexcept>    // logic_error, invalid_argument, out_of_range
-#include <deque>
+#include <memory>       // make_unique
+#include <algorithm>    // min, max, stable_sort, count, fill
+#include <numeric>      // iota
+#include <stdexcept>    // invalid_argument, out_of_range, length_error
+#include <vector>
+#include <functional>   // function
 
 using namespace brtools::trie;
 using namespace brtools::trie::detail;
 using namespace std;
 
-using diff_index_type = string_bit_index_type<uint16_t>;
+using brtools::util::string_ref;
 
-namespace brtools
-{
-namespace trie
-{
-namespace detail
-{
-    struct trie_node
-    {
-        enum flag_type : uint16_t
-        { 
-            branch_node = 0u,
-            leaf_node   = 1u,
-        } flag;
-
-        diff_index_type first_diff_bit_index;
-
-        unique_ptr<trie_node> left;
-        unique_ptr<trie_node> right;
-
-        stringtrie::string_id_type id;
-    };
-}
-}
-}
+using diff_index_type = string_bit_index_type<uint32_t>;
 
 namespace
 {
     /**
-     * Zips two strings for iterating through characters in the two strings at
-     * the same time. If one string is longer than the other, and the iterator
-     * has exausted all characters in the shorter string, then the NUL character
-     * is returned for the shorter string.
+     * Keys longer than diff_index_type can address would share bit indices.
+     *
+     * @throws std::length_error if str is too long.
      */
-    class string_zip
+    void check_length(const string_ref str)
     {
-    public:
-        class iterator
+        if (str.length() > diff_index_type::max_string_length)
         {
-        public:
-            using difference_type   = size_t;
-            using value_type        = tuple<char, char>;
-            using reference         = value_type&;
-            using pointer           = value_type*;
-            using iterator_category = input_iterator_tag;
-        
-        public:
-            iterator(const string::const_iterator& iter1, 
-                     const string::const_iterator& iter1_end,
-                     const string::const_iterator& iter2,
-                     const string::const_iterator& iter2_end
-                     )
-            : _m_iter1(iter1), _m_end1(iter1_end)
-            , _m_iter2(iter2), _m_end2(iter2_end) {}
-            
-            iterator& operator++()
-            { return _m_iter1 == _m_end1 ? _m_end1 : ++_m_iter1, 
-                     _m_iter2 == _m_end2 ? _m_end2 : ++_m_iter2, 
-                     *this; }
-
-            iterator  operator++(int)
-            { return iterator(_m_iter1 == _m_end1 ? _m_end1 : _m_iter1++, _m_end1,
-                              _m_iter2 == _m_end2 ? _m_end2 : _m_iter2++, _m_end2); }
-
-            bool operator==(const iterator& other) const
-            { return _m_iter1 == other._m_iter1 && _m_iter2 == other._m_iter2; }
-
-            bool operator!=(const iterator& other) const
-            { return !(*this == other); }
-
-            value_type operator*() const
-            { return make_tuple(
-                        _m_iter1 == _m_end1 ? '\0' : *_m_iter1,
-                        _m_iter2 == _m_end2 ? '\0' : *_m_iter2
-                     ); }
-        private:
-            string::const_iterator _m_iter1, _m_end1;
-            string::const_iterator _m_iter2, _m_end2;
-        };
-
-    public:
-        string_zip(const string& str1, const string& str2)
-        : _m_str1(str1), _m_str2(str2) {}
-
-        iterator begin() { return iterator(_m_str1.cbegin(), _m_str1.cend(), 
-                                           _m_str2.cbegin(), _m_str2.cend()); }
-        iterator end() { return iterator(_m_str1.cend(), _m_str1.cend(),
-                                         _m_str2.cend(), _m_str2.cend()); }
-        
-    private:
-        const string& _m_str1;
-        const string& _m_str2;
-    };
-
+            throw length_error("The string is too long for the trie.");
+        }
+    }
 
     /**
-     * Finds the index of first occurrence of 1 in the given argument. Behavior
-     * is only defined if num is not 0, and _Tp is an unsigned integral type.
+     * Gets the side of the child to traverse to given the string and the
+     * branch node. If the bit in string at first_diff_bit_index is 0, the
+     * left child is chosen, otherwise the right child is chosen.
      */
-    template<typename _Tp>
-    constexpr size_t count_leading_zeros(const _Tp num)
+    bool next_side(const char* const str, const size_t length, const trie_node& node)
     {
-        return 1 == num >> (numeric_limits<_Tp>::digits - 1) ? 0 : 1 + count_leading_zeros<_Tp>(num << 1);
+        return diff_index_type(node.first_diff_bit_index).bit_in(str, length);
     }
 
     /**
-     * Finds the bit index of the first bit where the two given strings differ.
+     * Retrieves the leaf reached by following the bits of str from the root.
+     * Only the final leaf is kept, so the walk does not allocate.
      *
-     * If the length of the two strings differ, then the diff bit is the first
-     * 1 bit in the longer string.
-     *
-     * If the two strings are completely identical, then there is no diff bit
-     * and the result is the max value.
-     *
-     * If either str1 or str2 or both contain the NUL char, the behavior is
-     * not defined.
+     * @param nodes Must not be empty.
      */
-    auto find_first_diff_bit_index(const string& str1, const string& str2)
+    trie_node_pool::node_ref find_leaf(const char* const str, const size_t length, const trie_node_pool& nodes)
     {
-        diff_index_type result;
-        result.char_index = 0;
-        for (const auto& chars : string_zip(str1, str2))
+        auto ref = nodes.root;
+        while (!trie_node_pool::is_leaf(ref))
         {
-            if (const diff_index_type::index_type diff = get<0>(chars) ^ get<1>(chars))
-            {
-                result.bit_index = count_leading_zeros(diff);
-                return result;
-            }
-            result.char_index = result.char_index + 1;
+            const auto& node = nodes[ref];
+            ref = node.children[next_side(str, length, node)];
         }
-        result.index = diff_index_type::max;
+        return ref;
+    }
+}
+
+
+stringtrie::stringtrie()
+: _m_nodes(make_unique<trie_node_pool>())
+, _m_strings(make_unique<string_pool>())
+{}
+
+stringtrie::~stringtrie() = default;
+
+stringtrie::stringtrie(const initializer_list<string>& strs)
+: stringtrie(vector<string_ref>(strs.begin(), strs.end()))
+{}
+
+stringtrie::stringtrie(const vector<string_ref>& strs, const key_order order)
+: stringtrie()
+{
+    // positions of strs in sorted order, repeated strings by position
+    vector<size_t> sorted(strs.size());
+    iota(sorted.begin(), sorted.end(), 0);
+    if (order == key_order::unsorted)
+    {
+        stable_sort(sorted.begin(), sorted.end(),
+                    [&strs](const size_t lhs, const size_t rhs) { return strs[lhs] < strs[rhs]; });
+    }
 
-        return result;
+    // marks the first occurrence of every string, whose id all occurrences share
+    vector<bool> is_first(strs.size(), true);
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        is_first[sorted[i]] = strs[sorted[i]] != strs[sorted[i - 1]];
     }
 
-    /**
-     * Gets the next node to traverse to given the string and the node.
-     * If the bit in string at bit_index is 0, the left node is chosen,
-     * otherwise the right node is chosen.
-     *
-     * @param  node Must not be nullptr and must not be a leaf.
-     * @return tie(next, other) next  is the chosen node by the algorithm,
-     *                          other is the node not chosen. 
-     */
-    template<typename _TrieNodeType>
-    auto next_node(const string& str, _TrieNodeType& node)
+    if (size_t(count(is_first.cbegin(), is_first.cend(), true)) > trie_node_pool::max_id + size_t(1))
+    {
+        throw length_error("The trie cannot hold that many strings.");
+    }
+    for (const auto str : strs)
     {
-        if (node->first_diff_bit_index[str] == 0)
+        check_length(str);
+    }
+
+    // associates ids in the order of strs
+    vector<string_id_type> ids(strs.size());
+    for (size_t i = 0; i < strs.size(); ++i)
+    {
+        if (is_first[i])
         {
-            return tie(node->left, node->right);
+            _m_strings->add(ids[i] = _m_id_dispenser.dispense(), strs[i]);
         }
-        else
+    }
+
+    // joins the strings in sorted order; the branch between two adjacent
+    // strings goes as deep along the rightmost path as its first diff bit
+    // allows, so the path is kept on a stack of branches with ascending
+    // first diff bits
+    auto& nodes = *_m_nodes;
+    vector<trie_node_pool::node_ref> rightmost_path;
+    string_ref previous;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        const auto position = sorted[i];
+        if (!is_first[position])
+        {
+            continue;
+        }
+
+        const auto new_leaf = trie_node_pool::leaf_ref(ids[position]);
+        if (nodes.root == trie_node_pool::null_ref)
+        {
+            nodes.root = new_leaf;
+            previous   = strs[position];
+            continue;
+        }
+
+        // the previous string is the rightmost leaf, and the closest to this
+        // one among the strings so far
+        const auto first_diff_bit_index = find_first_diff_bit_index<uint32_t>(previous, strs[position]).index;
+        previous = strs[position];
+
+        while (!rightmost_path.empty() && nodes[rightmost_path.back()].first_diff_bit_index > first_diff_bit_index)
         {
-            return tie(node->right, node->left);
+            rightmost_path.pop_back();
         }
+
+        // the subtrie below the new branch holds only smaller strings, so it
+        // goes to the left and the new leaf to the right
+        const auto subtrie = rightmost_path.empty() ? nodes.root : nodes[rightmost_path.back()].children[1];
+        const auto new_branch = nodes.add(first_diff_bit_index, subtrie, new_leaf);
+        (rightmost_path.empty() ? nodes.root : nodes[rightmost_path.back()].children[1]) = new_branch;
+        rightmost_path.push_back(new_branch);
     }
+}
 
-    /**
-     * Retrieves the path to a leaf node in the stringtrie.
-     *
-     * @param root Root of the trie or subtrie. Must not be nullptr.
-     */
-    template<typename _TrieNodeType>
-    auto find_path_to_leaf(const string& str, _TrieNodeType& root)
+stringtrie::string_id_type stringtrie::insert(string str)
+{
+    auto& nodes = *_m_nodes;
+    check_length(str);
+
+    if (nodes.root == trie_node_pool::null_ref)
     {
-        auto node = ref(root);
-        deque<decltype(node)> path;
+        const auto id = _m_id_dispenser.dispense();
+        _m_strings->add(id, str);
+        nodes.root = trie_node_pool::leaf_ref(id);
+        return id;
+    }
 
-        while (static_cast<decltype(root)>(node)->flag != trie_node::leaf_node)
+    diff_index_type first_diff_bit_index;
+    {   // determine if the string already exists
+        const auto diff_with_leaf = trie_node_pool::leaf_id(find_leaf(str.data(), str.length(), nodes));
+        const auto diff_with_str  = (*_m_strings)[diff_with_leaf];
+
+        if ((first_diff_bit_index = find_first_diff_bit_index<uint32_t>(str, diff_with_str))
+             == diff_index_type::max)
         {
-            path.push_back(node);
-            tie(node, ignore) = next_node(str, static_cast<_TrieNodeType&>(node));
+            // two strings are identical,
+            // no new string inserted
+            return diff_with_leaf;
         }
+    }
 
-        path.push_back(node);
+    // string is not in trie yet, find on the path where to add it:
+    // nodes with smaller first_diff_bit_index should be closer to root,
+    // so the new branch goes above the first node on the path that is
+    // either a leaf or differs at a later bit
+    auto parent = trie_node_pool::null_ref;  // while ref is the root
+    auto side   = false;
+    auto ref    = nodes.root;
+    while (!trie_node_pool::is_leaf(ref) && nodes[ref].first_diff_bit_index < first_diff_bit_index.index)
+    {
+        parent = ref;
+        side   = next_side(str.data(), str.length(), nodes[ref]);
+        ref    = nodes[ref].children[side];
+    }
 
-        return path;
+    const auto id = _m_id_dispenser.dispense();
+    try
+    {
+        if (id > trie_node_pool::max_id)
+        {
+            throw length_error("The trie cannot hold any more strings.");
+        }
+        _m_strings->add(id, str);
+    }
+    catch (...)
+    {
+        _m_id_dispenser.recycle(id);
+        throw;
     }
-}
 
+    // points the chosen child of the new branch to the new leaf,
+    // and the other child to the existing subtrie
+    const auto new_leaf = trie_node_pool::leaf_ref(id);
+    const auto new_branch = first_diff_bit_index[str]
+                          ? nodes.add(first_diff_bit_index.index, ref, new_leaf)
+                          : nodes.add(first_diff_bit_index.index, new_leaf, ref);
 
-stringtrie::stringtrie() = default;
-stringtrie::~stringtrie() = default;
+    // points the parent to the new branch
+    (parent == trie_node_pool::null_ref ? nodes.root : nodes[parent].children[side]) = new_branch;
+    return id;
+}
 
-stringtrie::stringtrie(const initializer_list<string>& strs)
+stringtrie::string_id_type stringtrie::erase(const string_ref str)
 {
-    for (const auto& str : strs)
+    auto& nodes = *_m_nodes;
+    if (nodes.root == trie_node_pool::null_ref)
+    {
+        return invalid;
+    }
+
+    // remembers the branch above the leaf, and where that branch hangs
+    auto grandparent = trie_node_pool::null_ref;
+    auto parent      = trie_node_pool::null_ref;
+    auto parent_side = false;
+    auto side        = false;
+    auto ref         = nodes.root;
+    while (!trie_node_pool::is_leaf(ref))
+    {
+        grandparent = parent;
+        parent_side = side;
+        parent      = ref;
+        side        = next_side(str.data(), str.length(), nodes[ref]);
+        ref         = nodes[ref].children[side];
+    }
+
+    const auto id = trie_node_pool::leaf_id(ref);
+    if ((*_m_strings)[id] != str)
+    {
+        return invalid;
+    }
+
+    if (parent == trie_node_pool::null_ref)
     {
-        insert(str);
+        // the last string; starts over as a new trie
+        nodes.clear();
+        _m_strings->remove(id);
+        _m_id_dispenser = util::id_dispenser<string_id_type>();
+        return id;
     }
+
+    // the sibling of the leaf takes the place of their branch
+    const auto sibling = nodes[parent].children[!side];
+    (grandparent == trie_node_pool::null_ref ? nodes.root : nodes[grandparent].children[parent_side]) = sibling;
+    nodes.remove(parent);
+
+    _m_strings->remove(id);
+    _m_id_dispenser.recycle(id);
+    return id;
 }
 
-stringtrie::string_id_type stringtrie::insert(string str)
+stringtrie::string_id_type stringtrie::find_id(const string& str) const
 {
-    using node_ref = unique_ptr<trie_node>&;
-
-    auto new_leaf = make_unique<trie_node>();
-    new_leaf->flag = trie_node::leaf_node;
+    return find_id(str.data(), str.length());
+}
 
-    if (!_m_root)
+stringtrie::string_id_type stringtrie::find_id(const char* const str, const size_t length) const
+{
+    if (_m_nodes->root == trie_node_pool::null_ref) 
     {
-        _m_root = move(new_leaf);
-        _m_strings[_m_root->id = _m_id_dispenser.dispense()] = move(str);
-        return _m_root->id;
+        return invalid;
     }
     else
     {
-        const auto& path_to_leaf   = find_path_to_leaf(str, _m_root);
-        auto new_branch = make_unique<trie_node>();
-        new_branch->flag = trie_node::branch_node;
-        new_branch->id   = invalid;
+        // the leaf only shares the bits tested on the way with str,
+        // so the whole string has to be compared
+        const auto id = trie_node_pool::leaf_id(find_leaf(str, length, *_m_nodes));
+        return (*_m_strings)[id] == string_ref(str, length) ? id : invalid;
+    }
+}
 
-        {   // determine if the string already exists
-            const auto& diff_with_leaf = static_cast<node_ref>(path_to_leaf.back());
-            const auto& diff_with_str  = _m_strings[diff_with_leaf->id];
+void stringtrie::find_ids(const string_ref* const keys, const size_t count, string_id_type* const ids) const
+{
+    // lookups in flight at once; enough to cover memory latency,
+    // few enough for their state to stay in registers and L1
+    constexpr size_t group_size = 16;
 
-            if ((new_branch->first_diff_bit_index = find_first_diff_bit_index(str, diff_with_str))
-                 == diff_index_type::max)
-            {
-                // two strings are identical,
-                // no new string inserted
-                return diff_with_leaf->id;
-            }
-        }
+    const auto& nodes = *_m_nodes;
+    if (nodes.root == trie_node_pool::null_ref)
+    {
+        fill(ids, ids + count, invalid);
+        return;
+    }
+
+    for (size_t group = 0; group < count; group += group_size)
+    {
+        const auto size = min(group_size, count - group);
+        const auto group_keys = keys + group;
 
-        // string is not in trie yet, find on the path where to add it
-        const auto id = new_leaf->id = _m_id_dispenser.dispense();
+        trie_node_pool::node_ref refs[group_size];
+        fill(refs, refs + size, nodes.root);
 
-        for (auto& pn : path_to_leaf)
+        // takes one step in each unfinished lookup, prefetching its next node
+        for (auto walking = size; walking > 0;)
         {
-            auto& path_node = static_cast<node_ref>(pn);
-            if (path_node->flag == trie_node::leaf_node ||
-                // nodes with smaller first_diff_bit_index should be closer to root
-                new_branch->first_diff_bit_index < path_node->first_diff_bit_index)
+            walking = 0;
+            for (size_t i = 0; i < size; ++i)
             {
-                // this means: [ next, other ] = [ new_leaf, path_node ]
-                // points the next node to the new leaf,
-                // points the other node to the existing branch.
-                next_node(str, new_branch) = forward_as_tuple(move(new_leaf), move(path_node));
-                // points path_node to the new branch 
-                path_node = move(new_branch);
-                _m_strings[id] = move(str);
-                return id;
+                if (!trie_node_pool::is_leaf(refs[i]))
+                {
+                    const auto& node = nodes[refs[i]];
+                    refs[i] = node.children[next_side(group_keys[i].data(), group_keys[i].length(), node)];
+                    if (!trie_node_pool::is_leaf(refs[i]))
+                    {
+                        nodes.prefetch(refs[i]);
+                        ++walking;
+                    }
+                }
             }
         }
 
-        throw logic_error("This should be unreachable.");
+        // the leaves only share the bits tested on the way with the keys,
+        // so the whole strings have to be compared
+        for (size_t i = 0; i < size; ++i)
+        {
+            _m_strings->prefetch(trie_node_pool::leaf_id(refs[i]));
+        }
+        for (size_t i = 0; i < size; ++i)
+        {
+            const auto id = trie_node_pool::leaf_id(refs[i]);
+            ids[group + i] = (*_m_strings)[id] == group_keys[i] ? id : invalid;
+        }
     }
 }
 
-stringtrie::string_id_type stringtrie::find_id(const string& str) const
+vector<stringtrie::string_id_type> stringtrie::find_ids(const vector<string_ref>& keys) const
 {
-    if (!_m_root) 
+    vector<string_id_type> ids(keys.size());
+    find_ids(keys.data(), keys.size(), ids.data());
+    return ids;
+}
+
+bool stringtrie::for_each_with_prefix(const string_ref prefix,
+                                      const function<bool(string_id_type, string_ref)>& visitor) const
+{
+    const auto& nodes = *_m_nodes;
+    if (nodes.root == trie_node_pool::null_ref)
     {
-        return invalid;
+        return true;
     }
-    else
+
+    // follows the prefix down to the first node testing a bit past it; all
+    // strings below share the bits before the bit their root tests, so they
+    // all start with the prefix if any one of them does
+    const auto prefix_bits = prefix.length() * numeric_limits<unsigned char>::digits;
+    auto subtrie = nodes.root;
+    while (!trie_node_pool::is_leaf(subtrie) && nodes[subtrie].first_diff_bit_index < prefix_bits)
     {
-        return static_cast<const unique_ptr<trie_node>&>(find_path_to_leaf(str, _m_root).back())->id;
+        subtrie = nodes[subtrie].children[next_side(prefix.data(), prefix.length(), nodes[subtrie])];
     }
-}
 
-string stringtrie::find_string(const string_id_type str_id) const
-{
-    if (str_id == invalid)
+    auto leftmost = subtrie;
+    while (!trie_node_pool::is_leaf(leftmost))
     {
-        throw invalid_argument("The given string id is invalid.");
+        leftmost = nodes[leftmost].children[0];
     }
-    else 
+    const auto str = (*_m_strings)[trie_node_pool::leaf_id(leftmost)];
+    if (str.length() < prefix.length() || string_ref(str.data(), prefix.length()) != prefix)
+    {
+        return true;
+    }
+
+    // visits the leaves from left to right
+    vector<trie_node_pool::node_ref> pending{ subtrie };
+    while (!pending.empty())
     {
-        const auto it = _m_strings.find(str_id);
-        if (it != _m_strings.end())
+        const auto ref = pending.back();
+        pending.pop_back();
+        if (trie_node_pool::is_leaf(ref))
         {
-            return it->second;
+            const auto id = trie_node_pool::leaf_id(ref);
+            if (!visitor(id, (*_m_strings)[id]))
+            {
+                return false;
+            }
         }
         else
         {
-            throw out_of_range("The given string id does not correspond to any string.");
+            pending.push_back(nodes[ref].children[1]);
+            pending.push_back(nodes[ref].children[0]);
         }
     }
+    return true;
+}
+
+bool stringtrie::for_each(const function<bool(string_id_type, string_ref)>& visitor) const
+{
+    return for_each_with_prefix(string_ref(), visitor);
+}
+
+string stringtrie::find_string(const string_id_type str_id) const
+{
+    return find_string_ref(str_id).str();
+}
+
+string_ref stringtrie::find_string_ref(const string_id_type str_id) const
+{
+    if (str_id == invalid)
+    {
+        throw invalid_argument("The given string id is invalid.");
+    }
+    else if (_m_strings->contains(str_id))
+    {
+        return (*_m_strings)[str_id];
+    }
+    else
+    {
+        throw out_of_range("The given string id does not correspond to any string.");
+    }
 }
@@ -0,0 +1,335 @@
+#include <brtools/trie/stringtrie.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_parser.h>
+#include <brtools/io/stream_writer.h>
+#include "detail/string_pool.h"
+#include "detail/symb_format.h"
+#include "detail/trie_node_pool.h"
+
+#include <cstdint>      // uint16_t, uint32_t
+#include <memory>       // unique_ptr, make_unique
+#include <stdexcept>    // length_error
+#include <string>
+#include <vector>
+
+using namespace brtools::io;
+using namespace brtools::trie;
+using namespace brtools::trie::detail;
+using namespace std;
+
+using brtools::error::integrity_error;
+
+namespace
+{
+    /**
+     * Converts the tree nodes of a SYMB block into a trie_node_pool,
+     * reading the strings of the leaves from the string table.
+     */
+    class symb_reader
+    {
+    public:
+        symb_reader(stream_parser& sp, trie_node_pool& nodes, string_pool& strings)
+        : _m_sp(sp), _m_nodes(nodes), _m_strings(strings)
+        {
+            const auto string_table_offset = _m_sp.read<uint32_t>();
+            const auto tree_offset         = _m_sp.read<uint32_t>();
+
+            _m_sp.seek_by_offset_from_base(string_table_offset);
+            _m_string_count = _m_sp.read<uint32_t>();
+            _m_string_table = string_table_offset + symb_format::string_table_entry;
+
+            _m_sp.seek_by_offset_from_base(tree_offset);
+            _m_root       = _m_sp.read<uint32_t>();
+            _m_node_count = _m_sp.read<uint32_t>();
+            _m_tree       = tree_offset + symb_format::tree_header_size;
+        }
+
+        void read()
+        {
+            if (_m_node_count == 0)
+            {
+                return;
+            }
+
+            // A hostile file can nest branches as deep as there are bit
+            // indices, so the tree is walked with a work list instead of
+            // recursion. A branch is added before its children, which are
+            // filled in as they are read.
+            vector<pending_node> pending{ { _m_root, -1, trie_node_pool::null_ref, 0 } };
+            while (!pending.empty())
+            {
+                const auto p = pending.back();
+                pending.pop_back();
+
+                const auto ref = read_node(p, pending);
+                if (p.parent == trie_node_pool::null_ref)
+                {
+                    _m_nodes.root = ref;
+                }
+                else
+                {
+                    _m_nodes[p.parent].children[p.side] = ref;
+                }
+            }
+        }
+
+    private:
+        /**
+         * A node yet to be read, and where to link it once it is.
+         */
+        struct pending_node
+        {
+            uint32_t index;
+
+            /**
+             * The bit index of the parent node, which has to be smaller than
+             * that of a branch below it. This also rules out cycles.
+             */
+            int32_t parent_bit;
+
+            /**
+             * The branch the node is a child of, or null_ref for the root.
+             */
+            trie_node_pool::node_ref parent;
+            unsigned                 side;
+        };
+
+        /**
+         * Marks the given node as read, which it must not have been before.
+         * Grows only to nodes that could be read, so that a node count made
+         * up by a malformed file allocates nothing.
+         */
+        void visit(const uint32_t index)
+        {
+            if (index >= _m_visited.size())
+            {
+                _m_visited.resize(index + size_t(1));
+            }
+            if (_m_visited[index])
+            {
+                throw integrity_error("A node is shared by several parents in the SYMB tree.");
+            }
+            _m_visited[index] = true;
+        }
+
+        /**
+         * Reads the given node, adding the children of a branch to pending.
+         * Every node is read at most once, since a node below two parents
+         * would make the tree a graph, whose subtrees could be read over and
+         * over.
+         */
+        trie_node_pool::node_ref read_node(const pending_node& node, vector<pending_node>& pending)
+        {
+            if (node.index >= _m_node_count)
+            {
+                throw integrity_error("Node index is out of range of the SYMB tree.");
+            }
+
+            _m_sp.seek_by_offset_from_base(_m_tree + streamoff(node.index) * symb_format::node_size);
+            const auto flags     = _m_sp.read<uint16_t>();
+            const auto bit       = _m_sp.read<uint16_t>();
+            const auto left      = _m_sp.read<uint32_t>();
+            const auto right     = _m_sp.read<uint32_t>();
+            const auto string_id = _m_sp.read<uint32_t>();
+            visit(node.index);
+
+            if (flags & symb_format::leaf_flag)
+            {
+                if (string_id >= _m_string_count || string_id > trie_node_pool::max_id)
+                {
+                    throw integrity_error("String id is out of range of the SYMB string table.");
+                }
+                if (_m_strings.contains(string_id))
+                {
+                    throw integrity_error("A string is in several leaves of the SYMB tree.");
+                }
+                _m_strings.add(string_id, read_string(string_id));
+                return trie_node_pool::leaf_ref(string_id);
+            }
+
+            if (bit <= node.parent_bit)
+            {
+                throw integrity_error("Bit indices do not increase down the SYMB tree.");
+            }
+            const auto ref = _m_nodes.add(bit, trie_node_pool::null_ref, trie_node_pool::null_ref);
+            pending.push_back({ right, bit, ref, 1 });
+            pending.push_back({ left,  bit, ref, 0 });
+            return ref;
+        }
+
+        string read_string(const uint32_t string_id)
+        {
+            _m_sp.seek_by_offset_from_base(_m_string_table + streamoff(string_id) * symb_format::string_table_entry);
+            _m_sp.seek_by_offset_from_base(_m_sp.read<uint32_t>());
+
+            string result;
+            for (char c; (c = _m_sp.read<char>()) != '\0';)
+            {
+                result.push_back(c);
+            }
+            return result;
+        }
+
+    private:
+        stream_parser&  _m_sp;
+        trie_node_pool& _m_nodes;
+        string_pool&    _m_strings;
+
+        uint32_t  _m_string_count;
+        streamoff _m_string_table;
+        uint32_t  _m_root;
+        uint32_t  _m_node_count;
+        streamoff _m_tree;
+
+        /**
+         * Whether each node has been read, by node index.
+         */
+        vector<bool> _m_visited;
+    };
+
+    struct symb_node
+    {
+        uint16_t flags;
+        uint16_t bit;
+        uint32_t left;
+        uint32_t right;
+        uint32_t string_id;
+    };
+
+    /**
+     * Lays out the trie rooted at root in pre-order, as BR tools do. A work
+     * list stands in for recursion, so that deep tries do not overflow the
+     * stack.
+     */
+    void lay_out(const trie_node_pool& nodes, const trie_node_pool::node_ref root, vector<symb_node>& result)
+    {
+        struct pending_node
+        {
+            trie_node_pool::node_ref ref;
+
+            /**
+             * The index in result of the parent, or no_index for the root.
+             */
+            uint32_t parent;
+            unsigned side;
+        };
+
+        vector<pending_node> pending{ { root, symb_format::no_index, 0 } };
+        while (!pending.empty())
+        {
+            const auto p = pending.back();
+            pending.pop_back();
+
+            const auto index = static_cast<uint32_t>(result.size());
+            if (trie_node_pool::is_leaf(p.ref))
+            {
+                result.push_back({ symb_format::leaf_flag, symb_format::no_bit,
+                                   symb_format::no_index, symb_format::no_index, trie_node_pool::leaf_id(p.ref) });
+            }
+            else
+            {
+                const auto& node = nodes[p.ref];
+                if (node.first_diff_bit_index >= symb_format::no_bit)
+                {
+                    throw length_error("The strings are too long for the SYMB format.");
+                }
+                result.push_back({ 0, static_cast<uint16_t>(node.first_diff_bit_index), 0, 0, symb_format::no_index });
+                pending.push_back({ node.children[1], index, 1 });
+                pending.push_back({ node.children[0], index, 0 });
+            }
+
+            if (p.parent != symb_format::no_index)
+            {
+                (p.side == 0 ? result[p.parent].left : result[p.parent].right) = index;
+            }
+        }
+    }
+}
+
+stream_parser& brtools::trie::operator>>(stream_parser& sp, stringtrie& trie)
+{
+    const stream_parser::read_scope scope(sp);
+    const auto offset_scope = sp.push_offset_base(sp.tell());
+
+    auto nodes   = make_unique<trie_node_pool>();
+    auto strings = make_unique<string_pool>();
+    symb_reader(sp, *nodes, *strings).read();
+
+    // ids missing from the tree remain available
+    util::id_dispenser<stringtrie::string_id_type> id_dispenser;
+    for (stringtrie::string_id_type id = 0; id < strings->id_count(); ++id)
+    {
+        id_dispenser.dispense();
+    }
+    for (stringtrie::string_id_type id = 0; id < strings->id_count(); ++id)
+    {
+        if (!strings->contains(id))
+        {
+            id_dispenser.recycle(id);
+        }
+    }
+
+    trie._m_nodes        = move(nodes);
+    trie._m_strings      = move(strings);
+    trie._m_id_dispenser = move(id_dispenser);
+    return sp;
+}
+
+stream_writer& brtools::trie::operator<<(stream_writer& sw, const stringtrie& trie)
+{
+    const auto& strings = *trie._m_strings;
+    const auto& nodes   = *trie._m_nodes;
+
+    // string table, followed by the strings
+    const uint32_t string_count = strings.id_count();
+    const uint32_t string_table_offset = symb_format::header_size;
+
+    vector<uint32_t> string_offsets;
+    auto offset = static_cast<uint32_t>(string_table_offset + symb_format::string_table_entry * (1 + string_count));
+    for (stringtrie::string_id_type id = 0; id < string_count; ++id)
+    {
+        if (strings.contains(id))
+        {
+            string_offsets.push_back(offset);
+            offset += static_cast<uint32_t>(strings[id].length() + 1);
+        }
+        else
+        {
+            string_offsets.push_back(symb_format::no_index);
+        }
+    }
+    const uint32_t padding     = (4 - offset % 4) % 4;
+    const uint32_t tree_offset = offset + padding;
+
+    vector<symb_node> tree;
+    if (nodes.root != trie_node_pool::null_ref)
+    {
+        lay_out(nodes, nodes.root, tree);
+    }
+
+    sw << string_table_offset << tree_offset;
+
+    sw << string_count;
+    for (const auto string_offset : string_offsets)
+    {
+        sw << string_offset;
+    }
+    for (stringtrie::string_id_type id = 0; id < string_count; ++id)
+    {
+        if (strings.contains(id))
+        {
+            const auto str = strings[id];
+            sw.write_raw(str.data(), str.length());
+            sw.write_raw("\0", 1);
+        }
+    }
+    sw.write_raw("\0\0\0", padding);
+
+    sw << (tree.empty() ? symb_format::no_index : uint32_t(0)) << static_cast<uint32_t>(tree.size());
+    for (const auto& node : tree)
+    {
+        // item ids are the string ids
+        sw << node.flags << node.bit << node.left << node.right << node.string_id << node.string_id;
+    }
+    return sw;
+}
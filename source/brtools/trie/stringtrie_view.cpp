@@ -0,0 +1,123 @@
+#include <brtools/trie/stringtrie_view.h>
+#include <brtools/error/integrity_error.h>
+#include "detail/string_bit_index_type.h"
+#include "detail/symb_format.h"
+
+#include <algorithm>    // min
+#include <cstring>      // memchr
+#include <stdexcept>    // out_of_range
+
+using namespace brtools::trie;
+using namespace brtools::trie::detail;
+using namespace std;
+
+using brtools::error::integrity_error;
+using brtools::util::string_ref;
+
+stringtrie_view::stringtrie_view(const char* const data, const size_t size, const size_t tree_number)
+: _m_data(data)
+, _m_size(size)
+{
+    _m_string_table = read_u32(0);
+    _m_string_count = read_u32(_m_string_table);
+
+    const auto tree = read_u32(sizeof(uint32_t) * (1 + tree_number));
+    _m_root         = read_u32(tree);
+    _m_node_count   = read_u32(tree + sizeof(uint32_t));
+    _m_tree         = size_t(tree) + symb_format::tree_header_size;
+
+    // the nodes and the string table are within the data
+    if (_m_node_count > (_m_size - min(_m_size, _m_tree)) / symb_format::node_size ||
+        _m_string_count > (_m_size - _m_string_table - symb_format::string_table_entry) / symb_format::string_table_entry)
+    {
+        throw integrity_error("The SYMB tree or string table is out of range of the data.");
+    }
+}
+
+stringtrie_view::string_id_type stringtrie_view::find_id(const string_ref str) const
+{
+    const auto node = find_leaf(str);
+    return node == 0 ? invalid : read_u32(node + symb_format::string_id_offset);
+}
+
+stringtrie_view::item_id_type stringtrie_view::find_item_id(const string_ref str) const
+{
+    const auto node = find_leaf(str);
+    return node == 0 ? invalid : read_u32(node + symb_format::item_id_offset);
+}
+
+string_ref stringtrie_view::find_string(const string_id_type str_id) const
+{
+    if (str_id >= _m_string_count)
+    {
+        throw out_of_range("The given string id does not correspond to any string.");
+    }
+
+    const auto offset = read_u32(_m_string_table + symb_format::string_table_entry * (1 + size_t(str_id)));
+    if (offset >= _m_size)
+    {
+        throw integrity_error("The SYMB string is out of range of the data.");
+    }
+
+    const auto str = _m_data + offset;
+    const auto end = static_cast<const char*>(memchr(str, '\0', _m_size - offset));
+    if (end == nullptr)
+    {
+        throw integrity_error("The SYMB string is not NUL-terminated within the data.");
+    }
+    return string_ref(str, end - str);
+}
+
+size_t stringtrie_view::find_leaf(const string_ref str) const
+{
+    if (_m_node_count == 0)
+    {
+        return 0;
+    }
+
+    // bit indices increase down the tree, which bounds the walk even if
+    // the tree is malformed
+    int32_t previous_bit = -1;
+    for (auto index = _m_root;;)
+    {
+        if (index >= _m_node_count)
+        {
+            throw integrity_error("Node index is out of range of the SYMB tree.");
+        }
+
+        const auto node = _m_tree + size_t(index) * symb_format::node_size;
+        if (read_u16(node + symb_format::flags_offset) & symb_format::leaf_flag)
+        {
+            // the leaf only shares the bits tested on the way with str,
+            // so the whole string has to be compared
+            const auto str_id = read_u32(node + symb_format::string_id_offset);
+            return str_id < _m_string_count && find_string(str_id) == str ? node : 0;
+        }
+
+        const auto bit = read_u16(node + symb_format::bit_offset);
+        if (bit <= previous_bit)
+        {
+            throw integrity_error("Bit indices do not increase down the SYMB tree.");
+        }
+        previous_bit = bit;
+
+        index = read_u32(node + (string_bit_index_type<uint16_t>(bit).bit_in(str.data(), str.length())
+                                 ? symb_format::right_offset : symb_format::left_offset));
+    }
+}
+
+uint32_t stringtrie_view::read_u32(const size_t offset) const
+{
+    return uint32_t(read_u16(offset)) << 16 | read_u16(offset + sizeof(uint16_t));
+}
+
+uint16_t stringtrie_view::read_u16(const size_t offset) const
+{
+    if (offset > _m_size || _m_size - offset < sizeof(uint16_t))
+    {
+        throw integrity_error("Offset is out of range of the SYMB data.");
+    }
+
+    const auto bytes = reinterpret_cast<const unsigned char*>(_m_data + offset);
+    return static_cast<uint16_t>(bytes[0] << 8 | bytes[1]);
+}
@@ -0,0 +1,92 @@
+#ifndef BRTOOLS_UTIL_PARALLEL_FOR_H
+#define BRTOOLS_UTIL_PARALLEL_FOR_H
+#pragma once
+
+#include <algorithm>    // std::min, std::max
+#include <atomic>
+#include <cstddef>      // size_t
+#include <exception>    // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace brtools
+{
+namespace util
+{
+    /**
+     * The number of threads to use when the caller does not specify one.
+     */
+    inline size_t default_thread_count()
+    {
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Invokes fn(i) for every i in [0, count), spread over thread_count
+     * threads, one of which is the calling thread. Indices are handed out one
+     * at a time to whichever thread is free, so uneven work evens itself out.
+     *
+     * Blocks until every invocation has returned. If any invocation throws,
+     * the remaining indices are abandoned and the first exception thrown is
+     * rethrown on the calling thread.
+     */
+    template<typename Fn>
+    void parallel_for(const size_t count, Fn&& fn, const size_t thread_count = default_thread_count())
+    {
+        const auto workers = std::min(count, thread_count);
+        if (workers <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                fn(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_index(0);
+        std::exception_ptr  first_error;
+        std::mutex          error_mutex;
+
+        const auto work = [&]
+        {
+            for (size_t i; (i = next_index++) < count;)
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    const std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!first_error)
+                    {
+                        first_error = std::current_exception();
+                    }
+                    next_index = count;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t t = 1; t < workers; ++t)
+        {
+            threads.emplace_back(work);
+        }
+        work();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (first_error)
+        {
+            std::rethrow_exception(first_error);
+        }
+    }
+}
+}
+
+#endif
@@ -24,9 +24,12 @@ namespace util
         /**
          * Populates _m_arguments with data extracted from stream. Reads values
          * from the given stream_parser.
+         *
+         * Braces guarantee the values are read in order of ParamTypes, which
+         * is not the case for the arguments of a parenthesized call.
          */
         stream_data_extractor(io::stream_parser& sp)
-        : _m_arguments(sp.read<ParamTypes>()...)
+        : _m_arguments{sp.read<ParamTypes>()...}
         {}
 
         // for subclass and outsiders to conveniently refer to its parent(this) class
@@ -0,0 +1,83 @@
+#include <fixtures/allocation_counter.h>
+
+#include <cstdlib>  // std::malloc, std::free
+#include <new>      // std::bad_alloc, std::nothrow_t
+
+namespace
+{
+    thread_local size_t allocations_on_thread = 0;
+
+    void* allocate(const size_t size) noexcept
+    {
+        ++allocations_on_thread;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+allocation_counter::allocation_counter()
+: _m_start(allocations_on_thread)
+{
+}
+
+size_t allocation_counter::count() const
+{
+    return allocations_on_thread - _m_start;
+}
+
+// Every form of the global operator new and delete is replaced, so that none
+// of the memory allocated here is freed by a form that was not, or the other
+// way around.
+
+void* operator new(const size_t size)
+{
+    if (void* const ptr = allocate(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](const size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* const ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* const ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* const ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* const ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* const ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* const ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,34 @@
+#ifndef BRTOOLS_TEST_FIXTURES_ALLOCATION_COUNTER_H
+#define BRTOOLS_TEST_FIXTURES_ALLOCATION_COUNTER_H
+#pragma once
+
+#include <cstddef>  // size_t
+
+/**
+ * Counts the allocations made through the global operator new on the calling
+ * thread while it exists, so that allocations of other threads, and of code
+ * outside the scope measured, are not counted.
+ *
+ * Counting relies on replacing the global operator new, which
+ * allocation_counter.cpp does for the whole executable it is linked into.
+ * It is thus linked only into brtools-allocation-tests, and not into the
+ * other tests or the sanitizer runs of them.
+ */
+class allocation_counter
+{
+public:
+    allocation_counter();
+    allocation_counter(const allocation_counter&) = delete;
+    allocation_counter& operator=(const allocation_counter&) = delete;
+
+    /**
+     * The number of allocations made on the calling thread since this
+     * counter was created.
+     */
+    size_t count() const;
+
+private:
+    size_t _m_start;
+};
+
+#endif
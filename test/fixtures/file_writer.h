@@ -0,0 +1,61 @@
+#ifndef BRTOOLS_TEST_FIXTURES_FILE_WRITER_H
+#define BRTOOLS_TEST_FIXTURES_FILE_WRITER_H
+#pragma once
+
+#include <brtools/io/stream_writer.h>
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t, uint32_t
+#include <sstream>  // std::ostringstream
+#include <string>
+
+/**
+ * Helpers to build BR files in tests. Files are written in big endian, as
+ * they are on the Wii, or in little endian if little_endian is set, to test
+ * files whose byte order is reversed from that.
+ */
+
+/**
+ * A writer to stm in the byte order of the file, whatever the byte order of
+ * the machine.
+ */
+inline brtools::io::stream_writer file_writer(std::ostringstream& stm, const bool little_endian = false)
+{
+    brtools::io::stream_writer w(stm);
+
+    const uint16_t byte_order_mark = 0xFEFF;
+    const bool machine_big_endian = reinterpret_cast<const unsigned char*>(&byte_order_mark)[0] == 0xFE;
+    if (machine_big_endian == little_endian)
+    {
+        w.reverse_byte_order();
+    }
+    return w;
+}
+
+/**
+ * Writes zeros until stm is at a multiple of alignment.
+ */
+inline void pad(brtools::io::stream_writer& w, std::ostringstream& stm, const size_t alignment)
+{
+    while (stm.tellp() % alignment != 0)
+    {
+        w << uint8_t(0);
+    }
+}
+
+/**
+ * A section with the given body, padded to 0x20 bytes, which its length
+ * includes.
+ */
+inline std::string section(const char* magic, const std::string& body, const bool little_endian = false)
+{
+    std::ostringstream stm;
+    auto w = file_writer(stm, little_endian);
+    w.write_raw(magic, 4);
+    w << uint32_t((8 + body.size() + 0x1F) / 0x20 * 0x20);
+    w.write_raw(body.data(), body.size());
+    pad(w, stm, 0x20);
+    return stm.str();
+}
+
+#endif
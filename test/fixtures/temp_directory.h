@@ -0,0 +1,124 @@
+#ifndef BRTOOLS_TEST_FIXTURES_TEMP_DIRECTORY_H
+#define BRTOOLS_TEST_FIXTURES_TEMP_DIRECTORY_H
+#pragma once
+
+#include <cerrno>       // errno, EEXIST
+#include <cstdio>       // std::remove
+#include <cstdlib>      // std::getenv
+#include <stdexcept>    // std::runtime_error
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+    #include <direct.h>     // _mkdir, _rmdir
+    #include <process.h>    // _getpid
+#else
+    #include <sys/stat.h>   // mkdir
+    #include <unistd.h>     // getpid, rmdir
+#endif
+
+/**
+ * A directory of its own for the files of a test, so that tests running in
+ * parallel do not collide. The directory and the files named through path
+ * are removed when it is destroyed, even if the test fails halfway.
+ */
+class temp_directory
+{
+public:
+    temp_directory()
+    {
+        // The process id keeps test processes apart, the counter keeps the
+        // directories of one process apart; a name left over from an earlier
+        // run is skipped.
+        static unsigned counter = 0;
+        const std::string base = temp_root() + "/brtools-tests-" + std::to_string(process_id()) + "-";
+        for (unsigned attempt = 0; attempt < 100; ++attempt)
+        {
+            const std::string name = base + std::to_string(counter++);
+            if (make_directory(name) == 0)
+            {
+                _m_path = name;
+                return;
+            }
+            if (errno != EEXIST)
+            {
+                break;
+            }
+        }
+        throw std::runtime_error("Could not create a temporary directory.");
+    }
+
+    temp_directory(const temp_directory&) = delete;
+    temp_directory& operator=(const temp_directory&) = delete;
+
+    ~temp_directory()
+    {
+        for (const auto& file : _m_files)
+        {
+            std::remove(file.c_str());
+        }
+        remove_directory(_m_path);
+    }
+
+    /**
+     * The path of the file with the given name in this directory, which is
+     * removed along with it.
+     */
+    std::string path(const std::string& file_name)
+    {
+        _m_files.push_back(_m_path + "/" + file_name);
+        return _m_files.back();
+    }
+
+private:
+    static std::string temp_root()
+    {
+    #if defined(_WIN32)
+        const char* const names[] = { "TMP", "TEMP" };
+        const char* const fallback = ".";
+    #else
+        const char* const names[] = { "TMPDIR" };
+        const char* const fallback = "/tmp";
+    #endif
+        for (const char* const name : names)
+        {
+            const char* const value = std::getenv(name);
+            if (value && *value)
+            {
+                return value;
+            }
+        }
+        return fallback;
+    }
+
+    static long process_id()
+    {
+    #if defined(_WIN32)
+        return _getpid();
+    #else
+        return getpid();
+    #endif
+    }
+
+    static int make_directory(const std::string& name)
+    {
+    #if defined(_WIN32)
+        return _mkdir(name.c_str());
+    #else
+        return mkdir(name.c_str(), 0700);
+    #endif
+    }
+
+    static void remove_directory(const std::string& name)
+    {
+    #if defined(_WIN32)
+        _rmdir(name.c_str());
+    #else
+        rmdir(name.c_str());
+    #endif
+    }
+
+    std::string              _m_path;
+    std::vector<std::string> _m_files;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <brtools/trie/stringtrie.h>
+#include <fixtures/allocation_counter.h>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::trie;
+using namespace std;
+
+TEST(stringtrie_allocation, find_string_ref)
+{
+    const stringtrie st = {"foo", "bar", ""};
+    const auto id = st.find_id("bar");
+
+    // references into the pool are not copies
+    const allocation_counter allocations;
+    const auto ref = st.find_string_ref(id);
+    EXPECT_EQ(0u, allocations.count());
+    EXPECT_EQ("bar", ref.str());
+}
+
+TEST(stringtrie_allocation, find_id)
+{
+    const stringtrie st = {"foo", "bar", "foobar", "barfoo", "foobarfoo", "barfoobar"};
+    const char buffer[] = "barfoobarbaz";
+
+    const allocation_counter allocations;
+    const auto barfoo    = st.find_id(buffer, 6);
+    const auto barfoobar = st.find_id(buffer, 9);
+    const auto missing   = st.find_id(buffer, 12);
+    EXPECT_EQ(0u, allocations.count());
+
+    EXPECT_EQ("barfoo",    st.find_string(barfoo));
+    EXPECT_EQ("barfoobar", st.find_string(barfoobar));
+    EXPECT_EQ(stringtrie::invalid, missing);
+}
+
+TEST(stringtrie_allocation, find_ids)
+{
+    vector<string> strs;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        strs.push_back("symbol_" + to_string(i * 7919 % 1000));
+    }
+    const stringtrie st(vector<brtools::util::string_ref>(strs.begin(), strs.end()));
+
+    vector<string> keys;
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        keys.push_back(i % 3 == 0 ? "missing_" + to_string(i) : strs[i * 31 % strs.size()]);
+    }
+    const vector<brtools::util::string_ref> key_refs(keys.begin(), keys.end());
+    vector<stringtrie::string_id_type> ids(keys.size());
+
+    // with caller-provided storage
+    const allocation_counter allocations;
+    st.find_ids(key_refs.data(), key_refs.size(), ids.data());
+    EXPECT_EQ(0u, allocations.count());
+
+    EXPECT_EQ(stringtrie::invalid, ids[0]);
+    EXPECT_EQ(st.find_id(keys[1]), ids[1]);
+}
+
+TEST(allocation_counter, counts_the_calling_thread)
+{
+    const allocation_counter allocations;
+    const vector<int> v(16);
+    EXPECT_EQ(1u, allocations.count());
+}
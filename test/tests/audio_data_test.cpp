@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <brtools/data/audio_data.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using namespace ::testing;
+using namespace brtools::data;
+using namespace std;
+
+TEST(planar_audio_data, layout)
+{
+    {   // Test 1: channels are aligned and do not overlap
+        pcm16_audio_data audio(3, 1000);
+        EXPECT_EQ(sample_format::pcm16, audio.format());
+        EXPECT_EQ(3u, audio.channel_count());
+        EXPECT_EQ(1000u, audio.frame_count());
+        for (size_t c = 0; c < 3; ++c)
+        {
+            EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(audio.channel(c)) % pcm16_audio_data::alignment);
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                audio.channel(c)[i] = static_cast<int16_t>(c * 1000 + i);
+            }
+        }
+        for (size_t c = 0; c < 3; ++c)
+        {
+            EXPECT_EQ(static_cast<int16_t>(c * 1000), audio.channel(c)[0]);
+            EXPECT_EQ(static_cast<int16_t>(c * 1000 + 999), audio.channel(c)[999]);
+        }
+    }
+
+    {   // Test 2: float samples, and empty buffers
+        const float32_audio_data audio(2, 1);
+        EXPECT_EQ(sample_format::float32, audio.format());
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(audio.channel(1)) % float32_audio_data::alignment);
+
+        const float32_audio_data empty;
+        EXPECT_EQ(0u, empty.channel_count());
+        EXPECT_EQ(0u, empty.frame_count());
+        EXPECT_TRUE(empty.unique());
+    }
+}
+
+TEST(planar_audio_data, slices_share_samples)
+{
+    pcm16_audio_data audio(2, 100);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        audio.channel(0)[i] = static_cast<int16_t>(i);
+        audio.channel(1)[i] = static_cast<int16_t>(-static_cast<int>(i));
+    }
+    EXPECT_TRUE(audio.unique());
+
+    auto slice = audio.slice(40, 20);
+    EXPECT_FALSE(audio.unique());
+    EXPECT_EQ(2u, slice.channel_count());
+    EXPECT_EQ(20u, slice.frame_count());
+    EXPECT_EQ(audio.channel(0) + 40, slice.channel(0));
+    EXPECT_EQ(-45, slice.channel(1)[5]);
+
+    // writes go to the shared samples
+    slice.channel(0)[0] = 1234;
+    EXPECT_EQ(1234, audio.channel(0)[40]);
+
+    // slices of slices, and the empty slice at the end
+    EXPECT_EQ(audio.channel(1) + 50, slice.slice(10, 10).channel(1));
+    EXPECT_EQ(0u, audio.slice(100, 0).frame_count());
+    EXPECT_THROW(audio.slice(90, 11), out_of_range);
+    EXPECT_THROW(slice.slice(21, 0), out_of_range);
+
+    // the samples outlive the buffer they were sliced from
+    audio = pcm16_audio_data();
+    EXPECT_TRUE(slice.unique());
+    EXPECT_EQ(1234, slice.channel(0)[0]);
+    EXPECT_EQ(59, slice.channel(0)[19]);
+}
+
+TEST(planar_audio_data, small_blocks_are_pooled)
+{
+    const int16_t* first = nullptr;
+    {
+        const pcm16_audio_data audio(2, 1000);
+        first = audio.channel(0);
+    }
+
+    // a buffer of the same size class gets the block back
+    const pcm16_audio_data again(2, 900);
+    EXPECT_EQ(first, again.channel(0));
+
+    auto moved = pcm16_audio_data(2, 900);
+    const auto samples = moved.channel(0);
+    const pcm16_audio_data target(move(moved));
+    EXPECT_EQ(samples, target.channel(0));
+    EXPECT_EQ(0u, moved.channel_count());
+}
+
+TEST(planar_audio_data, too_large)
+{
+    const auto max = numeric_limits<size_t>::max();
+    EXPECT_THROW(pcm16_audio_data(1, max), length_error);
+    EXPECT_THROW(pcm16_audio_data(16, max / 16), length_error);
+    EXPECT_THROW(float32_audio_data(max / 64, 64), length_error);
+}
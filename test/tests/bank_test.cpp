@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <brtools/data/bank/bank.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_writer.h>
+#include <fixtures/file_writer.h>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace ::testing;
+using namespace std;
+using namespace brtools::data::bank;
+using brtools::error::integrity_error;
+using brtools::io::stream_writer;
+
+namespace
+{
+    void reference(stream_writer& w, const uint8_t type, const uint32_t offset)
+    {
+        w << uint8_t(type != 0) << type << uint16_t(0) << offset;
+    }
+
+    void region(stream_writer& w, const int32_t wave_index, const uint8_t original_key, const float tune)
+    {
+        uint32_t tune_bits;
+        memcpy(&tune_bits, &tune, sizeof(tune));
+
+        w << wave_index
+          << uint8_t(127) << uint8_t(100) << uint8_t(90) << uint8_t(80)
+          << uint8_t(1) << uint8_t(0) << uint8_t(0) << uint8_t(0)
+          << original_key << uint8_t(127) << uint8_t(64) << uint8_t(0)
+          << tune_bits;
+
+        // envelope and randomizer tables, which are not read
+        for (size_t i = 0; i < 7; ++i)
+        {
+            w << uint32_t(0);
+        }
+    }
+
+    /**
+     * Instrument 0 plays one region for everything. Instrument 1 splits the
+     * notes at 60 by a range table, and the lower notes split the velocities
+     * at 64. Instrument 2 plays only note 60, through an index table.
+     * Instrument 3 is missing.
+     */
+    string make_rbnk(const uint8_t instrument_1_type = 2)
+    {
+        ostringstream body_stm;
+        {
+            auto w = file_writer(body_stm);
+            w << uint32_t(4);
+            reference(w, 1, 0xF0);
+            reference(w, instrument_1_type, 0x24);
+            reference(w, 3, 0x4C);
+            reference(w, 0, 0);
+
+            // 0x24: notes of instrument 1
+            w << uint8_t(2) << uint8_t(59) << uint8_t(127) << uint8_t(0);
+            reference(w, 2, 0x38);
+            reference(w, 1, 0xC0);
+
+            // 0x38: velocities of the lower notes of instrument 1
+            w << uint8_t(2) << uint8_t(63) << uint8_t(127) << uint8_t(0);
+            reference(w, 1, 0x60);
+            reference(w, 1, 0x90);
+
+            // 0x4C: notes of instrument 2
+            w << uint8_t(60) << uint8_t(61) << uint16_t(0);
+            reference(w, 1, 0x60);
+            reference(w, 0, 0);
+
+            region(w, 10, 60, 1.5f);    // 0x60
+            region(w, 11, 64, 0.0f);    // 0x90
+            region(w, 12, 72, 0.0f);    // 0xC0
+            region(w, 13, 48, -2.0f);   // 0xF0
+        }
+        const auto body = body_stm.str();
+
+        ostringstream stm;
+        auto w = file_writer(stm);
+        w.write_raw("RBNK", 4);
+        w << uint16_t(0xFEFF) << uint16_t(0x0101)
+          << uint32_t(0x20 + 8 + body.size() + 0x0C)
+          << uint16_t(0x20) << uint16_t(2)
+          << uint32_t(0x20) << uint32_t(8 + body.size())
+          << uint32_t(0x20 + 8 + body.size()) << uint32_t(0x0C);
+
+        w.write_raw("DATA", 4);
+        w << uint32_t(8 + body.size());
+        w.write_raw(body.data(), body.size());
+
+        w.write_raw("WAVE", 4);
+        w << uint32_t(0x0C) << uint32_t(0);
+        return stm.str();
+    }
+}
+
+TEST(bank, regions_by_note_and_velocity)
+{
+    istringstream stm(make_rbnk());
+    const auto b = bank::make_bank(stm);
+    EXPECT_EQ(4u, b.instrument_count());
+
+    // the region shared by instruments 1 and 2 is read once
+    EXPECT_EQ(4u, b.regions().size());
+
+    {   // Test 1: a single region
+        const auto r = b.find(0, 0, 0);
+        ASSERT_NE(nullptr, r);
+        EXPECT_EQ(13, r->wave_index);
+        EXPECT_EQ(48, r->original_key);
+        EXPECT_EQ(-2.0f, r->tune);
+        EXPECT_EQ(r, b.find(0, 127, 127));
+    }
+
+    {   // Test 2: notes, then velocities, by range
+        ASSERT_NE(nullptr, b.find(1, 59, 63));
+        EXPECT_EQ(10, b.find(1, 59, 63)->wave_index);
+        EXPECT_EQ(1.5f, b.find(1, 0, 0)->tune);
+        EXPECT_EQ(127, b.find(1, 0, 0)->adsr.attack);
+        EXPECT_EQ(80, b.find(1, 0, 0)->adsr.release);
+        EXPECT_EQ(11, b.find(1, 59, 64)->wave_index);
+        EXPECT_EQ(12, b.find(1, 60, 0)->wave_index);
+        EXPECT_EQ(12, b.find(1, 127, 127)->wave_index);
+
+        // velocities past 127 play as 127
+        EXPECT_EQ(11, b.find(1, 0, 1000)->wave_index);
+    }
+
+    {   // Test 3: notes by index, and missing regions and instruments
+        EXPECT_EQ(b.find(1, 0, 0), b.find(2, 60, 127));
+        EXPECT_EQ(nullptr, b.find(2, 61, 0));
+        EXPECT_EQ(nullptr, b.find(2, 59, 0));
+        EXPECT_EQ(nullptr, b.find(3, 60, 0));
+        EXPECT_EQ(nullptr, b.find(4, 60, 0));
+    }
+}
+
+TEST(bank, integrity_errors)
+{
+    {   // Test 1: file magic
+        auto content = make_rbnk();
+        content[0] = 'S';
+        istringstream stm(content);
+        EXPECT_THROW(bank::make_bank(stm), integrity_error);
+    }
+
+    {   // Test 2: reference of an unknown type
+        istringstream stm(make_rbnk(7));
+        EXPECT_THROW(bank::make_bank(stm), integrity_error);
+    }
+
+    {   // Test 3: a velocity that refers to a range table instead of a region
+        auto content = make_rbnk();
+        content[0x28 + 0x3D] = 2;
+        istringstream stm(content);
+        EXPECT_THROW(bank::make_bank(stm), integrity_error);
+    }
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <brtools/trie/concurrent_stringtrie.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::trie;
+using namespace std;
+
+TEST(concurrent_stringtrie, insert_and_find)
+{
+    concurrent_stringtrie trie;
+    const concurrent_stringtrie::reader reader(trie);
+
+    {   // Test 1: empty trie
+        const auto snapshot = reader.take_snapshot();
+        EXPECT_EQ(0u, snapshot.size());
+        EXPECT_EQ(concurrent_stringtrie::invalid, snapshot.find_id("SEQ"));
+        EXPECT_THROW(snapshot.find_string(0), out_of_range);
+    }
+
+    const vector<string> strs{ "SEQ_BGM_TITLE", "SEQ_SE_JUMP", "SEQ_BGM_STAGE_1", "STRM_BGM", "", "SEQ" };
+    for (size_t i = 0; i < strs.size(); ++i)
+    {
+        EXPECT_EQ(i, trie.insert(strs[i]));
+    }
+
+    {   // Test 2: every string is found, and repeated insertions keep ids
+        const auto snapshot = reader.take_snapshot();
+        EXPECT_EQ(strs.size(), snapshot.size());
+        for (size_t i = 0; i < strs.size(); ++i)
+        {
+            EXPECT_EQ(i, snapshot.find_id(strs[i]));
+            EXPECT_EQ(strs[i], snapshot.find_string(static_cast<concurrent_stringtrie::string_id_type>(i)));
+            EXPECT_EQ(i, trie.insert(strs[i]));
+        }
+        EXPECT_EQ(concurrent_stringtrie::invalid, snapshot.find_id("SEQ_BGM"));
+        EXPECT_THROW(snapshot.find_string(concurrent_stringtrie::invalid), invalid_argument);
+    }
+}
+
+TEST(concurrent_stringtrie, snapshots_are_unaffected_by_insertions)
+{
+    concurrent_stringtrie trie;
+    trie.insert("SEQ_BGM_TITLE");
+    const concurrent_stringtrie::reader reader(trie);
+
+    const auto before = reader.take_snapshot();
+    const auto id = trie.insert("SEQ_BGM_STAGE_1");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        trie.insert("SEQ_SE_" + to_string(i));
+    }
+
+    EXPECT_EQ(1u, before.size());
+    EXPECT_EQ(0u, before.find_id("SEQ_BGM_TITLE"));
+    EXPECT_EQ(concurrent_stringtrie::invalid, before.find_id("SEQ_BGM_STAGE_1"));
+    EXPECT_THROW(before.find_string(id), out_of_range);
+
+    const auto after = reader.take_snapshot();
+    EXPECT_EQ(102u, after.size());
+    EXPECT_EQ(id, after.find_id("SEQ_BGM_STAGE_1"));
+    EXPECT_EQ(0u, after.find_id("SEQ_BGM_TITLE"));
+}
+
+TEST(concurrent_stringtrie, readers_during_insertions)
+{
+    const size_t string_count = 5000;
+    concurrent_stringtrie trie;
+    atomic<bool> done{ false };
+    atomic<size_t> mismatches{ 0 };
+
+    vector<thread> readers;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&trie, &done, &mismatches]()
+        {
+            const concurrent_stringtrie::reader reader(trie);
+            while (!done.load())
+            {
+                // every string in a snapshot is found under its id
+                const auto snapshot = reader.take_snapshot();
+                for (concurrent_stringtrie::string_id_type id = 0; id < snapshot.size(); id += 37)
+                {
+                    if (snapshot.find_id(snapshot.find_string_ref(id)) != id)
+                    {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i < string_count; ++i)
+    {
+        EXPECT_EQ(i, trie.insert("archive/sound_" + to_string(i * 7919 % string_count)));
+    }
+    done.store(true);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(0u, mismatches.load());
+    const concurrent_stringtrie::reader reader(trie);
+    for (size_t i = 0; i < string_count; ++i)
+    {
+        EXPECT_EQ(i, reader.find_id("archive/sound_" + to_string(i * 7919 % string_count)));
+    }
+}
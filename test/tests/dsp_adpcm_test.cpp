@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <brtools/data/dsp_adpcm.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/data/dsp_adpcm_kernels.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::data;
+using namespace std;
+using brtools::error::integrity_error;
+
+TEST(dsp_adpcm, known_samples)
+{
+    dsp_adpcm::coefficients coefs = {};
+    coefs.pairs[1][0] = 2048;   // the previous sample, times 1.0
+
+    const char frames[] = {
+        0x02, 0x17, static_cast<char>(0xF8), 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x1C, 0x77, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    dsp_adpcm::history hist;
+    hist.previous = 30000;
+    int16_t samples[16];
+    dsp_adpcm::decode(frames, 16, coefs, hist, samples);
+
+    // pair 0 predicts nothing, so samples are the nibbles times the scale of 4
+    EXPECT_EQ(4, samples[0]);
+    EXPECT_EQ(28, samples[1]);
+    EXPECT_EQ(-4, samples[2]);
+    EXPECT_EQ(-32, samples[3]);
+    EXPECT_EQ(0, samples[4]);
+
+    // pair 1 carries the previous sample, clamping at the int16 range
+    EXPECT_EQ(7 * 4096, samples[14]);
+    EXPECT_EQ(32767, samples[15]);
+    EXPECT_EQ(32767, hist.previous);
+    EXPECT_EQ(7 * 4096, hist.before_previous);
+}
+
+TEST(dsp_adpcm, nibble_addresses)
+{
+    // the first two nibbles of a frame are its header
+    EXPECT_EQ(0u, dsp_adpcm::nibble_address_to_samples(0));
+    EXPECT_EQ(0u, dsp_adpcm::nibble_address_to_samples(2));
+    EXPECT_EQ(13u, dsp_adpcm::nibble_address_to_samples(15));
+    EXPECT_EQ(14u, dsp_adpcm::nibble_address_to_samples(16));
+    EXPECT_EQ(14u, dsp_adpcm::nibble_address_to_samples(18));
+    EXPECT_EQ(29u, dsp_adpcm::nibble_address_to_samples(35));
+}
+
+TEST(dsp_adpcm, vector_decoder_matches_scalar)
+{
+    uint32_t seed = 2024;
+    const auto next_random = [&seed]() { return seed = seed * 1103515245u + 12345u, seed >> 8; };
+
+    const size_t sample_count = 14 * 300 + 5;
+    vector<char> frames(dsp_adpcm::frame_bytes(sample_count));
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        // a valid coefficient pair in every header
+        frames[i] = static_cast<char>(i % dsp_adpcm::frame_size == 0 ? next_random() & 0x7F : next_random());
+    }
+    dsp_adpcm::coefficients coefs;
+    for (auto& pair : coefs.pairs)
+    {
+        pair[0] = static_cast<int16_t>(next_random() % 8192 - 4096);
+        pair[1] = static_cast<int16_t>(next_random() % 8192 - 4096);
+    }
+
+    dsp_adpcm::history reference_hist;
+    reference_hist.previous        = 1234;
+    reference_hist.before_previous = -5678;
+    vector<int16_t> reference(sample_count);
+    dsp_adpcm::detail::decode_scalar(frames.data(), sample_count, coefs, reference_hist, reference.data());
+
+    dsp_adpcm::history hist;
+    hist.previous        = 1234;
+    hist.before_previous = -5678;
+    vector<int16_t> samples(sample_count);
+    dsp_adpcm::decode(frames.data(), sample_count, coefs, hist, samples.data());
+
+    EXPECT_EQ(reference, samples);
+    EXPECT_EQ(reference_hist.previous, hist.previous);
+    EXPECT_EQ(reference_hist.before_previous, hist.before_previous);
+}
+
+TEST(dsp_adpcm, channels_into_audio_data)
+{
+    dsp_adpcm::coefficients coefs = {};
+    const char left[]  = { 0x00, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,  0x00, 0x22, 0, 0, 0, 0, 0, 0 };
+    const char right[] = { 0x01, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,  0x01, 0x22, 0, 0, 0, 0, 0, 0 };
+    vector<dsp_adpcm::channel> channels{ { left, coefs, {} }, { right, coefs, {} } };
+
+    {   // Test 1: a frame at a time continues where it stopped
+        const auto first = dsp_adpcm::decode(channels, 14);
+        EXPECT_EQ(2u, first.channel_count());
+        EXPECT_EQ(14u, first.frame_count());
+        EXPECT_EQ(1, first.channel(0)[13]);
+        EXPECT_EQ(2, first.channel(1)[13]);
+
+        const auto second = dsp_adpcm::decode(channels, 2);
+        EXPECT_EQ(2, second.channel(0)[0]);
+        EXPECT_EQ(4, second.channel(1)[1]);
+    }
+
+    {   // Test 2: coefficient pair out of range
+        const char bad[] = { static_cast<char>(0x80), 0, 0, 0, 0, 0, 0, 0 };
+        dsp_adpcm::history hist;
+        int16_t samples[14];
+        EXPECT_THROW(dsp_adpcm::decode(bad, 14, coefs, hist, samples), integrity_error);
+    }
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <brtools/trie/frozen_stringtrie.h>
+#include <brtools/trie/stringtrie.h>
+#include <brtools/error/integrity_error.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::trie;
+using namespace std;
+using brtools::error::integrity_error;
+
+TEST(frozen_stringtrie, same_lookups_as_trie)
+{
+    vector<string> strs;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        strs.push_back("stream/bgm_" + to_string(i * 7919 % 2000) + (i % 3 ? "_intro" : ""));
+    }
+    strs.push_back("");
+    strs.push_back("s");
+
+    const stringtrie st(vector<brtools::util::string_ref>(strs.begin(), strs.end()));
+    const frozen_stringtrie frozen(st);
+
+    EXPECT_EQ(strs.size(), frozen.size());
+    for (const auto& str : strs)
+    {
+        const auto id = st.find_id(str);
+        EXPECT_EQ(id,  frozen.find_id(str));
+        EXPECT_EQ(str, frozen.find_string(id));
+    }
+
+    for (const auto& missing : { "stream/", "stream/bgm_1_intr", "stream/bgm_1_introx", "x" })
+    {
+        EXPECT_EQ(frozen_stringtrie::invalid, frozen.find_id(missing)) << missing;
+    }
+
+    EXPECT_THROW(frozen.find_string(frozen_stringtrie::invalid), invalid_argument);
+    EXPECT_THROW(frozen.find_string(static_cast<frozen_stringtrie::string_id_type>(strs.size())), out_of_range);
+
+    // smaller than the characters and a 32-bit id per string alone
+    size_t characters = 0;
+    for (const auto& str : strs)
+    {
+        characters += str.size();
+    }
+    EXPECT_LT(frozen.bytes_per_key(), double(characters) / strs.size() + sizeof(uint32_t));
+}
+
+TEST(frozen_stringtrie, mapped_buffer)
+{
+    const stringtrie st = {"foo", "bar", "foobar"};
+    const frozen_stringtrie frozen(st);
+
+    // stands in for a mapped file
+    vector<uint64_t> mapped((frozen.data_size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    memcpy(mapped.data(), frozen.data(), frozen.data_size());
+    const frozen_stringtrie view(reinterpret_cast<const char*>(mapped.data()), frozen.data_size());
+
+    EXPECT_EQ(st.find_id("foobar"), view.find_id("foobar"));
+    EXPECT_EQ("bar", view.find_string(st.find_id("bar")));
+    EXPECT_EQ(frozen_stringtrie::invalid, view.find_id("baz"));
+
+    {   // Test 2: not a frozen trie
+        auto corrupt = mapped;
+        reinterpret_cast<char*>(corrupt.data())[0] = 'X';
+        EXPECT_THROW(frozen_stringtrie(reinterpret_cast<const char*>(corrupt.data()), frozen.data_size()), integrity_error);
+        EXPECT_THROW(frozen_stringtrie(reinterpret_cast<const char*>(mapped.data()), 8), integrity_error);
+    }
+}
+
+TEST(frozen_stringtrie, corrupt_buffer)
+{
+    const stringtrie st = {"foo", "bar", "foobar"};
+    const frozen_stringtrie frozen(st);
+
+    vector<uint64_t> mapped((frozen.data_size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    memcpy(mapped.data(), frozen.data(), frozen.data_size());
+
+    // the counts and widths follow the magic and the byte order mark
+    const auto field = [](vector<uint64_t>& buffer, const size_t index) -> uint32_t&
+    {
+        return reinterpret_cast<uint32_t*>(buffer.data())[2 + index];
+    };
+    const auto open = [&frozen](const vector<uint64_t>& buffer)
+    {
+        frozen_stringtrie(reinterpret_cast<const char*>(buffer.data()), frozen.data_size());
+    };
+
+    {   // Test 1: more keys than the sections hold
+        auto corrupt = mapped;
+        field(corrupt, 0) = 1000;       // key_count
+        field(corrupt, 1) = 1000;       // id_count
+        field(corrupt, 2) = 1999;       // node_count
+        field(corrupt, 3) = 63;         // bucket_count
+        EXPECT_THROW(open(corrupt), integrity_error);
+    }
+
+    {   // Test 2: a node count that does not match the key count
+        auto corrupt = mapped;
+        field(corrupt, 2) += 2;
+        EXPECT_THROW(open(corrupt), integrity_error);
+    }
+
+    {   // Test 3: a field wider than a word
+        auto corrupt = mapped;
+        field(corrupt, 5) = 65;         // id_width
+        EXPECT_THROW(open(corrupt), integrity_error);
+    }
+
+    {   // Test 4: a string longer than the strings section
+        auto corrupt = mapped;
+        const auto strings = reinterpret_cast<const uint64_t*>(corrupt.data())[11];
+        reinterpret_cast<char*>(corrupt.data())[strings] = 0x7F;
+        EXPECT_THROW(open(corrupt), integrity_error);
+    }
+
+    EXPECT_NO_THROW(open(mapped));
+}
+
+TEST(frozen_stringtrie, empty)
+{
+    const frozen_stringtrie frozen{stringtrie()};
+    EXPECT_EQ(0u, frozen.size());
+    EXPECT_EQ(frozen_stringtrie::invalid, frozen.find_id(""));
+    EXPECT_THROW(frozen.find_string(0), out_of_range);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <brtools/util/id_dispenser.h>
+#include <brtools/util/concurrent_id_dispenser.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::util;
+using namespace std;
+
+TEST(id_dispenser, reuses_smallest_recycled_id)
+{
+    id_dispenser<uint32_t> ids;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(i, ids.dispense());
+    }
+
+    {   // Test 1: smallest first
+        ids.recycle(7);
+        ids.recycle(3);
+        ids.recycle(5);
+        EXPECT_EQ(3u, ids.dispense());
+        EXPECT_EQ(5u, ids.dispense());
+        EXPECT_EQ(7u, ids.dispense());
+        EXPECT_EQ(10u, ids.dispense());
+    }
+
+    {   // Test 2: recycling the largest id drops the recycled ids below it
+        ids.recycle(8);
+        ids.recycle(7);
+        ids.recycle(2);
+        ids.recycle(10);
+        ids.recycle(9);
+        EXPECT_EQ(2u, ids.dispense());
+        EXPECT_EQ(7u, ids.dispense());
+        EXPECT_EQ(8u, ids.dispense());
+        EXPECT_EQ(9u, ids.dispense());
+    }
+}
+
+TEST(id_dispenser, matches_ordered_set)
+{
+    // ids spanning several words per level of the bitmap; the id dispensed
+    // is always the smallest not in use
+    id_dispenser<uint32_t> ids;
+    vector<uint32_t> in_use;
+    set<uint32_t> free_ids;   // below the largest id in use
+    uint32_t seed = 12345;
+    const auto next_random = [&seed]() { return seed = seed * 1103515245u + 12345u; };
+
+    for (size_t i = 0; i < 300000; ++i)
+    {
+        if (in_use.empty() || next_random() % 5 < 3)
+        {
+            const auto largest = free_ids.size() + in_use.size();
+            const auto expected = free_ids.empty() ? static_cast<uint32_t>(largest) : *free_ids.begin();
+            free_ids.erase(expected);
+
+            const auto id = ids.dispense();
+            ASSERT_EQ(expected, id);
+            in_use.push_back(id);
+        }
+        else
+        {
+            const auto position = next_random() % in_use.size();
+            const auto id = in_use[position];
+            in_use[position] = in_use.back();
+            in_use.pop_back();
+            ids.recycle(id);
+
+            free_ids.insert(id);
+            while (!free_ids.empty() && *free_ids.rbegin() == free_ids.size() + in_use.size() - 1)
+            {
+                free_ids.erase(prev(free_ids.end()));
+            }
+        }
+    }
+}
+
+TEST(concurrent_id_dispenser, single_thread)
+{
+    {   // Test 1: smallest free id first, until all are in use
+        concurrent_id_dispenser<uint32_t> ids(5000);
+        for (uint32_t i = 0; i < 5000; ++i)
+        {
+            ASSERT_EQ(i, ids.dispense());
+        }
+        EXPECT_THROW(ids.dispense(), length_error);
+
+        ids.recycle(4097);
+        ids.recycle(64);
+        EXPECT_EQ(64u, ids.dispense());
+        EXPECT_EQ(4097u, ids.dispense());
+        EXPECT_THROW(ids.dispense(), length_error);
+    }
+
+    {   // Test 2: small capacities
+        concurrent_id_dispenser<uint32_t> none(0);
+        EXPECT_THROW(none.dispense(), length_error);
+
+        concurrent_id_dispenser<uint32_t> one(1);
+        EXPECT_EQ(0u, one.dispense());
+        EXPECT_THROW(one.dispense(), length_error);
+        one.recycle(0);
+        EXPECT_EQ(0u, one.dispense());
+    }
+}
+
+TEST(concurrent_id_dispenser, threads_never_share_ids)
+{
+    const size_t capacity = 1000;
+    concurrent_id_dispenser<uint32_t> ids(capacity);
+    unique_ptr<atomic<bool>[]> held(new atomic<bool>[capacity]);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        held[i].store(false);
+    }
+    atomic<size_t> conflicts{ 0 };
+
+    vector<thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&ids, &held, &conflicts]()
+        {
+            vector<uint32_t> mine;
+            for (size_t i = 0; i < 20000; ++i)
+            {
+                if (mine.size() < 200 && i % 3 != 2)
+                {
+                    const auto id = ids.dispense();
+                    if (held[id].exchange(true))
+                    {
+                        ++conflicts;
+                    }
+                    mine.push_back(id);
+                }
+                else if (!mine.empty())
+                {
+                    held[mine.back()].store(false);
+                    ids.recycle(mine.back());
+                    mine.pop_back();
+                }
+            }
+            for (const auto id : mine)
+            {
+                held[id].store(false);
+                ids.recycle(id);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(0u, conflicts.load());
+
+    // every id is free again
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        ASSERT_EQ(i, ids.dispense());
+    }
+    EXPECT_THROW(ids.dispense(), length_error);
+}
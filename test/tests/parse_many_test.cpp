@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <brtools/data/sequence/parse_many.h>
+#include <brtools/data/sequence/events.h>
+#include <brtools/data/sequence/visitor.h>
+#include <brtools/error/integrity_error.h>
+#include <fixtures/temp_directory.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace std;
+using namespace brtools::data::sequence;
+using brtools::error::integrity_error;
+
+/**
+ * Tests that every file is reported exactly once, either parsed or failed,
+ * and that failures do not stop the remaining files.
+ */
+TEST(parse_many, parsed_and_failed_files)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x3C"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x10"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x30"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x0C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x10"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+/* 2C */ "\x80\x04"                 // wait: 0x04 ticks
+/* 2E */ "\xFF"                     // fin
+/* 2F */ "\x00"                     // padding
+
+/* 30 */ "LABL"                     // section magic
+/* 34 */ "\x00\x00\x00\x0C"         // section length
+/* 38 */ "\x00\x00\x00\x00"         // number of labels: 0
+/* 3C */ ""s;
+
+    constexpr size_t FILE_COUNT = 64;
+
+    // every third file is not an RSEQ file, and the last one does not exist
+    temp_directory directory;
+    vector<string> paths;
+    for (size_t i = 0; i < FILE_COUNT; ++i)
+    {
+        paths.push_back(directory.path(to_string(i) + ".brseq"));
+        if (i + 1 < FILE_COUNT)
+        {
+            ofstream(paths.back(), ios_base::binary) << (i % 3 == 0 ? "RSAR"s + STM_CONTENT.substr(4) : STM_CONTENT);
+        }
+    }
+
+    struct tick_counter : visitor
+    {
+        void visit(const brtools::data::sequence::wait& e, const operation&) override
+        {   ticks += e.tick_count(); }
+
+        void visit(const fin&, const operation& vop) override
+        {   vop.end(); }
+
+        uint32_t ticks = 0;
+    };
+
+    parse_options options;
+    options.thread_count = 4;
+    options.max_files_in_flight = 3;
+
+    vector<int> parsed(FILE_COUNT), failed(FILE_COUNT);
+    parse_many(paths, options,
+               [&parsed](const size_t index, sequence& seq)
+               {
+                   tick_counter counter;
+                   seq.traverse(counter);
+                   EXPECT_EQ(0x04u, counter.ticks);
+                   ++parsed[index];
+               },
+               [&failed, &paths](const size_t index, const exception_ptr error)
+               {
+                   if (index + 1 < paths.size())
+                   {
+                       EXPECT_THROW(rethrow_exception(error), integrity_error);
+                   }
+                   ++failed[index];
+               });
+
+    for (size_t i = 0; i < FILE_COUNT; ++i)
+    {
+        const bool should_fail = i % 3 == 0 || i + 1 == FILE_COUNT;
+        EXPECT_EQ(should_fail ? 0 : 1, parsed[i]) << paths[i];
+        EXPECT_EQ(should_fail ? 1 : 0, failed[i]) << paths[i];
+    }
+}
@@ -13,6 +13,26 @@ using namespace std;
 using namespace brtools::data::sequence;
 using brtools::error::integrity_error;
 
+namespace
+{
+    /**
+     * Points types::variable::memory at the given memory for as long as the
+     * guard exists, so that no test leaves it pointing at memory gone.
+     */
+    struct variable_memory_guard
+    {
+        explicit variable_memory_guard(int16_t* const memory)
+        {
+            brtools::data::types::variable::memory = memory;
+        }
+
+        ~variable_memory_guard()
+        {
+            brtools::data::types::variable::memory = nullptr;
+        }
+    };
+}
+
 /**
  * Tests that when file magic is not RSEQ, integrity_error is thrown.
  */
@@ -380,7 +400,7 @@ TEST(sequence, multiple_events)
 
     // specify memory for variables to use
     int16_t memory[48] = {};
-    brtools::data::types::variable::memory = memory;
+    const variable_memory_guard guard(memory);
 
     {   // expectations in order
         InSequence s;
@@ -546,3 +566,484 @@ TEST(sequence, reference_resolving_and_traversal_ordering)
 
     seq.traverse(visitor);
 }
+
+/**
+ * Tests that checkpoints are taken at the tick intervals, and that seeking
+ * resumes from the nearest checkpoint instead of the start of the sequence.
+ */
+TEST(sequence, checkpoints_and_seek)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x4C"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x20"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x40"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x0C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x20"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+/* 2C */ "\x80\x04"                 // wait: 0x04 ticks
+/* 2E */ "\xE1\x00\x78"             // tempo: 120 bpm
+/* 31 */ "\x80\x04"                 // wait: 0x04 ticks
+/* 33 */ "\x80\x05"                 // wait: 0x05 ticks
+/* 35 */ "\x80\x06"                 // wait: 0x06 ticks
+/* 37 */ "\xFF"                     // fin
+
+/* 38 */ "\x00\x00\x00\x00\x00\x00\x00\x00" // padding
+
+/* 40 */ "LABL"                     // section magic
+/* 44 */ "\x00\x00\x00\x0C"         // section length
+/* 48 */ "\x00\x00\x00\x00"         // number of labels: 0
+/* 4C */ ""s;
+
+    istringstream stm(STM_CONTENT);
+    const auto seq = sequence::make_sequence(stm);
+    using wait = brtools::data::sequence::wait;
+
+    sequence::checkpoint_table checkpoints;
+    {   // Test 1: checkpoints are taken at the start and past every 8 ticks:
+        // 0, 4 + 4 = 8, and 8 + 5 + 6 = 19 since the wait of 5 ticks spans 16
+        NiceMock<mock_sequence_visitor> visitor;
+        checkpoints = seq.make_checkpoints(visitor, 8);
+
+        ASSERT_EQ(3u, checkpoints.size());
+        EXPECT_EQ(0u,  checkpoints[0].tick);
+        EXPECT_EQ(0u,  checkpoints[0].tempo);
+        EXPECT_EQ(8u,  checkpoints[1].tick);
+        EXPECT_EQ(120, checkpoints[1].tempo);
+        EXPECT_EQ(19u, checkpoints[2].tick);
+    }
+
+    {   // Test 2: seeking fast-forwards only from the nearest checkpoint
+        NiceMock<mock_sequence_visitor> fast_forward;
+        EXPECT_CALL(fast_forward, visit(A<const wait&>(), A<const visitor::operation&>())).Times(0);
+
+        const auto at_8 = seq.seek(checkpoints, fast_forward, 8);
+        EXPECT_EQ(8u, at_8.tick);
+    }
+
+    {   // Test 3: seeking between checkpoints, then resuming traversal
+        NiceMock<mock_sequence_visitor> fast_forward;
+        EXPECT_CALL(fast_forward,
+                    visit(Matcher<const wait&>(Property(&wait::tick_count, 0x05)),
+                          A<const visitor::operation&>()));
+
+        const auto at_10 = seq.seek(checkpoints, fast_forward, 10);
+        EXPECT_EQ(13u, at_10.tick);
+        EXPECT_EQ(120, at_10.tempo);
+
+        mock_sequence_visitor visitor;
+        InSequence s;
+        EXPECT_CALL(visitor,
+                    visit(Matcher<const wait&>(Property(&wait::tick_count, 0x06)),
+                          A<const visitor::operation&>()));
+        EXPECT_CALL(visitor, visit(A<const fin&>(), A<const visitor::operation&>()));
+
+        seq.traverse(visitor, at_10);
+    }
+}
+
+/**
+ * Tests that checkpoints copy the variable memory given to them, and that
+ * seeking and resuming restore it.
+ */
+TEST(sequence, checkpoints_capture_variables)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x4C"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x20"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x40"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x0C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x20"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+/* 2C */ "\xF0\x80\x20\x00\x05"     // set_v: variable 0x20 = 0x05
+/* 31 */ "\x80\x04"                 // wait: 0x04 ticks
+/* 33 */ "\xF0\x81\x20\x00\x03"     // add_v: variable 0x20 += 0x03
+/* 38 */ "\x80\x04"                 // wait: 0x04 ticks
+/* 3A */ "\xF0\x81\x20\x00\x01"     // add_v: variable 0x20 += 0x01
+/* 3F */ "\xFF"                     // fin
+
+/* 40 */ "LABL"                     // section magic
+/* 44 */ "\x00\x00\x00\x0C"         // section length
+/* 48 */ "\x00\x00\x00\x00"         // number of labels: 0
+/* 4C */ ""s;
+
+    istringstream stm(STM_CONTENT);
+    const auto seq = sequence::make_sequence(stm);
+
+    int16_t memory[48] = {};
+    const sequence::variable_memory variables{ memory, 48 };
+
+    sequence::checkpoint_table checkpoints;
+    {   // Test 1: every checkpoint holds the variables as they were at its tick
+        NiceMock<mock_sequence_visitor> visitor;
+        checkpoints = seq.make_checkpoints(visitor, 4, variables);
+
+        ASSERT_EQ(3u, checkpoints.size());
+        ASSERT_EQ(48u, checkpoints[1].variables.size());
+        EXPECT_EQ(0, checkpoints[0].variables[0x20]);
+        EXPECT_EQ(5, checkpoints[1].variables[0x20]);
+        EXPECT_EQ(8, checkpoints[2].variables[0x20]);
+        EXPECT_EQ(9, memory[0x20]);
+    }
+
+    {   // Test 2: seeking restores the variables, and resuming carries on
+        NiceMock<mock_sequence_visitor> visitor;
+        const auto at_4 = seq.seek(checkpoints, visitor, 4, variables);
+        EXPECT_EQ(5, memory[0x20]);
+        EXPECT_EQ(5, at_4.variables[0x20]);
+
+        seq.traverse(visitor, at_4, variables);
+        EXPECT_EQ(9, memory[0x20]);
+    }
+
+    {   // Test 3: slots past the given memory are neither read nor written,
+        // and neither is types::variable::memory
+        int16_t global_memory[48] = {};
+        const variable_memory_guard guard(global_memory);
+
+        int16_t short_memory[] = { 1, 2, 3, 4 };
+        NiceMock<mock_sequence_visitor> visitor;
+        checkpoints = seq.make_checkpoints(visitor, 4, { short_memory, 4 });
+
+        ASSERT_EQ(3u, checkpoints.size());
+        EXPECT_EQ(vector<int16_t>({ 1, 2, 3, 4 }), checkpoints[2].variables);
+        EXPECT_EQ(0, global_memory[0x20]);
+    }
+
+    {   // Test 4: without memory, checkpoints capture no variables
+        NiceMock<mock_sequence_visitor> visitor;
+        checkpoints = seq.make_checkpoints(visitor, 4);
+        EXPECT_TRUE(checkpoints[1].variables.empty());
+    }
+}
+
+/**
+ * Tests the discovery of tracks, and traversing them in both execution modes.
+ */
+TEST(sequence, track_traversal)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x54"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x28"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x48"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x0C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x28"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+         // track 0
+/* 2C */ "\xFE\x00\x03"             // track usage: tracks 0 and 1
+/* 2F */ "\x88\x01\x00\x00\x12"     // open track number: 0x01, offset to track: 0x12
+/* 34 */ "\x88\x02\x00\x00\x12"     // open track number: 0x02, unused
+/* 39 */ "\x80\x02"                 // wait: 0x02 ticks
+/* 3B */ "\x80\x04"                 // wait: 0x04 ticks
+/* 3D */ "\xFF"                     // fin
+         // track 1
+/* 3E */ "\x80\x01"                 // wait: 0x01 tick
+/* 40 */ "\x80\x03"                 // wait: 0x03 ticks
+/* 42 */ "\xFF"                     // fin
+
+/* 43 */ "\x00\x00\x00\x00\x00"     // padding
+
+/* 48 */ "LABL"                     // section magic
+/* 4C */ "\x00\x00\x00\x0C"         // section length
+/* 50 */ "\x00\x00\x00\x00"         // number of labels: 0
+/* 54 */ ""s;
+
+    istringstream stm(STM_CONTENT);
+    const auto seq = sequence::make_sequence(stm);
+    using wait = brtools::data::sequence::wait;
+
+    const auto wait_of = [](const uint32_t ticks)
+    {   return Matcher<const wait&>(Property(&wait::tick_count, ticks)); };
+
+    const auto end_on_fin = [](mock_sequence_visitor& visitor)
+    {
+        ON_CALL(visitor, visit(A<const fin&>(), A<const visitor::operation&>()))
+            .WillByDefault(Invoke([](const auto&, const auto& vop) { vop.end(); }));
+    };
+
+    {   // Test 1: the unused track is not discovered
+        const auto tracks = seq.tracks();
+        ASSERT_EQ(2u, tracks.size());
+        EXPECT_EQ(1u, tracks.count(0));
+        EXPECT_EQ(1u, tracks.count(1));
+    }
+
+    {   // Test 2: interleaved tracks advance together by tick
+        NiceMock<mock_sequence_visitor> track_0, track_1;
+        end_on_fin(track_0);
+        end_on_fin(track_1);
+
+        InSequence s;
+        EXPECT_CALL(track_0, visit(wait_of(0x02), A<const visitor::operation&>()));
+        EXPECT_CALL(track_1, visit(wait_of(0x01), A<const visitor::operation&>()));
+        EXPECT_CALL(track_1, visit(wait_of(0x03), A<const visitor::operation&>()));
+        EXPECT_CALL(track_0, visit(wait_of(0x04), A<const visitor::operation&>()));
+        EXPECT_CALL(track_1, visit(A<const fin&>(), A<const visitor::operation&>()));
+        EXPECT_CALL(track_0, visit(A<const fin&>(), A<const visitor::operation&>()));
+
+        seq.traverse_tracks([&](const size_t track_no) -> visitor&
+                            {   return track_no == 0 ? track_0 : track_1; },
+                            sequence::track_execution::interleaved);
+    }
+
+    {   // Test 3: parallel tracks each run their own events, in order
+        NiceMock<mock_sequence_visitor> track_0, track_1;
+        end_on_fin(track_0);
+        end_on_fin(track_1);
+
+        Sequence s0, s1;
+        EXPECT_CALL(track_0, visit(wait_of(0x02), A<const visitor::operation&>())).InSequence(s0);
+        EXPECT_CALL(track_0, visit(wait_of(0x04), A<const visitor::operation&>())).InSequence(s0);
+        EXPECT_CALL(track_0, visit(A<const fin&>(), A<const visitor::operation&>())).InSequence(s0);
+        EXPECT_CALL(track_1, visit(wait_of(0x01), A<const visitor::operation&>())).InSequence(s1);
+        EXPECT_CALL(track_1, visit(wait_of(0x03), A<const visitor::operation&>())).InSequence(s1);
+        EXPECT_CALL(track_1, visit(A<const fin&>(), A<const visitor::operation&>())).InSequence(s1);
+
+        seq.traverse_tracks([&](const size_t track_no) -> visitor&
+                            {   return track_no == 0 ? track_0 : track_1; },
+                            sequence::track_execution::parallel);
+    }
+}
+
+/**
+ * Tests that tracks use the variable memory given for each of them.
+ */
+TEST(sequence, track_variables)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x4C"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x20"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x40"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x0C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x20"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+         // track 0
+/* 2C */ "\xFE\x00\x03"             // track usage: tracks 0 and 1
+/* 2F */ "\x88\x01\x00\x00\x0E"     // open track number: 0x01, offset to track: 0x0E
+/* 34 */ "\xF0\x81\x20\x00\x02"     // add_v: variable 0x20 += 0x02
+/* 39 */ "\xFF"                     // fin
+         // track 1
+/* 3A */ "\xF0\x81\x20\x00\x05"     // add_v: variable 0x20 += 0x05
+/* 3F */ "\xFF"                     // fin
+
+/* 40 */ "LABL"                     // section magic
+/* 44 */ "\x00\x00\x00\x0C"         // section length
+/* 48 */ "\x00\x00\x00\x00"         // number of labels: 0
+/* 4C */ ""s;
+
+    istringstream stm(STM_CONTENT);
+    const auto seq = sequence::make_sequence(stm);
+
+    int16_t global_memory[48] = {};
+    const variable_memory_guard guard(global_memory);
+
+    NiceMock<mock_sequence_visitor> track_0, track_1;
+    for (auto visitor : { &track_0, &track_1 })
+    {
+        ON_CALL(*visitor, visit(A<const fin&>(), A<const visitor::operation&>()))
+            .WillByDefault(Invoke([](const auto&, const auto& vop) { vop.end(); }));
+    }
+    const auto visitor_of = [&](const size_t track_no) -> visitor&
+    {   return track_no == 0 ? track_0 : track_1; };
+
+    {   // Test 1: parallel tracks each use their own memory
+        int16_t memory[2][48] = {};
+        seq.traverse_tracks(visitor_of, sequence::track_execution::parallel, [&](const size_t track_no)
+                            {   return sequence::variable_memory{ memory[track_no], 48 }; });
+
+        EXPECT_EQ(2, memory[0][0x20]);
+        EXPECT_EQ(5, memory[1][0x20]);
+        EXPECT_EQ(0, global_memory[0x20]);
+    }
+
+    {   // Test 2: parallel tracks given no memory run without it
+        seq.traverse_tracks(visitor_of, sequence::track_execution::parallel);
+        EXPECT_EQ(0, global_memory[0x20]);
+    }
+
+    {   // Test 3: interleaved tracks given no memory share the global memory
+        seq.traverse_tracks(visitor_of, sequence::track_execution::interleaved);
+        EXPECT_EQ(7, global_memory[0x20]);
+    }
+}
+
+/**
+ * Tests that the parallel linear scan visits every event exactly once, and
+ * reduces the visitors of all chunks.
+ */
+TEST(sequence, parallel_for_each_event)
+{
+    // enough events to be split into several chunks
+    constexpr size_t WAIT_COUNT = 20000;
+
+    const auto big_endian = [](const uint32_t value)
+    {
+        return string{ static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                       static_cast<char>(value >>  8), static_cast<char>(value) };
+    };
+
+    string events;
+    for (size_t i = 0; i < WAIT_COUNT; ++i)
+    {
+        events += "\x80\x01"s;      // wait: 0x01 tick
+    }
+    events += "\xFF"s;              // fin
+    events.resize((events.size() + 3) / 4 * 4, '\0');  // padding
+
+    const uint32_t data_length = 0x0C + events.size();
+    const auto STM_CONTENT =
+        "RSEQ"s                             // file magic
+      + "\xFE\xFF"s                         // big endian BOM
+      + "\x01\x00"s                         // file version
+      + big_endian(0x20 + data_length + 0x0C) // file length
+      + "\x00\x20"s                         // file header length
+      + "\x00\x02"s                         // number of file sections
+      + big_endian(0x20)                    // offset to DATA section
+      + big_endian(data_length)             // length of DATA section
+      + big_endian(0x20 + data_length)      // offset to LABL section
+      + big_endian(0x0C)                    // length of LABL section
+
+      + "DATA"s                             // section magic
+      + big_endian(data_length)             // section length
+      + big_endian(0x0C)                    // section header size
+      + events
+
+      + "LABL"s                             // section magic
+      + big_endian(0x0C)                    // section length
+      + big_endian(0);                      // number of labels: 0
+
+    istringstream stm(STM_CONTENT);
+    const auto seq = sequence::make_sequence(stm);
+
+    struct counter : brtools::data::sequence::visitor
+    {
+        void visit(const brtools::data::sequence::wait& e, const operation&) override
+        {   ++waits; ticks += e.tick_count(); }
+
+        void visit(const fin&, const operation&) override
+        {   ++fins; }
+
+        size_t waits = 0, ticks = 0, fins = 0;
+    };
+
+    size_t visitors_made = 0;
+    const auto result = seq.parallel_for_each_event(
+        [&visitors_made] { ++visitors_made; return counter(); },
+        [](counter& result, const counter& other)
+        {
+            result.waits += other.waits;
+            result.ticks += other.ticks;
+            result.fins  += other.fins;
+        });
+
+    EXPECT_LT(1u, visitors_made);
+    EXPECT_EQ(WAIT_COUNT, result.waits);
+    EXPECT_EQ(WAIT_COUNT, result.ticks);
+    EXPECT_EQ(1u, result.fins);
+}
+
+/**
+ * Tests that decoding in parallel yields the same sequence as decoding
+ * serially, including calls across pieces and a label pointing into the
+ * middle of an event.
+ */
+TEST(sequence, parallel_decoding)
+{
+    const auto STM_CONTENT =
+/* 00 */ "RSEQ"                     // file magic
+/* 04 */ "\xFE\xFF"                 // big endian BOM
+/* 06 */ "\x01\x00"                 // file version
+/* 08 */ "\x00\x00\x00\x68"         // file length
+/* 0C */ "\x00\x20"                 // file header length
+/* 0E */ "\x00\x02"                 // number of file sections
+/* 10 */ "\x00\x00\x00\x20"         // offset to DATA section
+/* 14 */ "\x00\x00\x00\x1C"         // length of DATA section
+/* 18 */ "\x00\x00\x00\x3C"         // offset to LABL section
+/* 1C */ "\x00\x00\x00\x2C"         // length of LABL section
+
+/* 20 */ "DATA"                     // section magic
+/* 24 */ "\x00\x00\x00\x1C"         // section length
+/* 28 */ "\x00\x00\x00\x0C"         // section header size
+/* 2C */ "\x80\x01"                 // wait: 0x01 tick
+/* 2E */ "\x8A\x00\x00\x09"         // call: offset 0x09
+/* 32 */ "\x80\x02"                 // wait: 0x02 ticks
+/* 34 */ "\xFF"                     // fin
+/* 35 */ "\x80\x03"                 // wait: 0x03 ticks
+/* 37 */ "\x80\x04"                 // wait: 0x04 ticks
+/* 39 */ "\xFD"                     // return
+
+/* 3A */ "\x00\x00"                 // padding
+
+/* 3C */ "LABL"                     // section magic
+/* 40 */ "\x00\x00\x00\x2C"         // section length
+/* 44 */ "\x00\x00\x00\x02"         // number of labels: 2
+/* 48 */ "\x00\x00\x00\x0C"         // offset to label 0
+/* 4C */ "\x00\x00\x00\x18"         // offset to label 1
+/* 50 */ "\x00\x00\x00\x09"         // label 0: offset to data
+/* 54 */ "\x00\x00\x00\x03"         // label 0: length of name
+/* 58 */ "sub\0"                    // label 0: name, padded
+/* 5C */ "\x00\x00\x00\x0C"         // label 1: offset to data, inside a wait
+/* 60 */ "\x00\x00\x00\x03"         // label 1: length of name
+/* 64 */ "mid\0"                    // label 1: name, padded
+/* 68 */ ""s;
+
+    struct recorder : brtools::data::sequence::visitor
+    {
+        void visit(const brtools::data::sequence::wait& e, const operation&) override
+        {   ticks.push_back(e.tick_count()); }
+
+        void visit(const brtools::data::sequence::call& e, const operation& vop) override
+        {   vop.call(e.destination()); }
+
+        void visit(const ret&, const operation& vop) override
+        {   vop.return_from_call(); }
+
+        void visit(const fin&, const operation& vop) override
+        {   vop.end(); }
+
+        vector<uint32_t> ticks;
+    };
+
+    const auto traversal_of = [&STM_CONTENT](const sequence::decoding mode)
+    {
+        istringstream stm(STM_CONTENT);
+        recorder visitor;
+        sequence::make_sequence(stm, mode).traverse(visitor);
+        return visitor.ticks;
+    };
+
+    const vector<uint32_t> expected{ 0x01, 0x03, 0x04, 0x02 };
+    EXPECT_EQ(expected, traversal_of(sequence::decoding::serial));
+    EXPECT_EQ(expected, traversal_of(sequence::decoding::parallel));
+}
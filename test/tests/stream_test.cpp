@@ -0,0 +1,561 @@
+#include <gtest/gtest.h>
+#include <brtools/data/stream/stream.h>
+#include <brtools/data/stream/player.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_writer.h>
+#include <fixtures/file_writer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using namespace std;
+using namespace brtools::data::stream;
+using brtools::data::encoding;
+using brtools::data::pcm16_audio_data;
+using brtools::error::integrity_error;
+using brtools::io::stream_writer;
+
+namespace dsp_adpcm = brtools::data::dsp_adpcm;
+
+namespace
+{
+    /**
+     * The contents of an RSTM file to build. Each channel holds its blocks
+     * back to back, the last one padded to 0x20 bytes.
+     */
+    struct rstm_description
+    {
+        encoding enc        = encoding::adpcm;
+        bool     loops      = false;
+        uint32_t loop_start = 0;
+        uint32_t block_size = 0;
+        uint32_t block_samples = 0;
+        uint32_t sample_count  = 0;
+        vector<string>                            channel_data;
+        vector<dsp_adpcm::coefficients>           coefs;
+        vector<vector<dsp_adpcm::history>>        block_histories;   // by channel, then block
+        uint32_t adpc_entry_samples = 0;
+        uint32_t adpc_entry_size    = 4;
+    };
+
+    string make_rstm(const rstm_description& d, const bool little_endian)
+    {
+        const auto channel_count = uint8_t(d.channel_data.size());
+        const auto block_count   = (d.sample_count + d.block_samples - 1) / d.block_samples;
+        const auto last_samples  = d.sample_count - (block_count - 1) * d.block_samples;
+        const auto last_size     = d.enc == encoding::adpcm ? dsp_adpcm::frame_bytes(last_samples)
+                                                            : last_samples * (d.enc == encoding::pcm16 ? 2 : 1);
+        const auto last_padded   = uint32_t((last_size + 0x1F) / 0x20 * 0x20);
+
+        const auto reference = [](stream_writer& w, const uint32_t offset)
+        {
+            w << uint8_t(1) << uint8_t(0) << uint16_t(0) << offset;
+        };
+
+        // HEAD, where offsets are from after the section length
+        ostringstream head_stm;
+        {
+            auto w = file_writer(head_stm, little_endian);
+            reference(w, 0x18);
+            reference(w, 0x4C);
+            reference(w, 0x58);
+
+            w << uint8_t(d.enc) << uint8_t(d.loops) << channel_count << uint8_t(0)
+              << uint16_t(32000) << uint16_t(0)
+              << d.loop_start << d.sample_count << uint32_t(0)
+              << block_count << d.block_size << d.block_samples
+              << uint32_t(last_size) << uint32_t(last_samples) << last_padded
+              << d.adpc_entry_samples << d.adpc_entry_size;
+
+            // track information, which is skipped
+            for (size_t i = 0; i < 0x0C; ++i)
+            {
+                w << uint8_t(0);
+            }
+
+            w << channel_count << uint8_t(0) << uint16_t(0);
+            const uint32_t channel_info_start = 0x5C + 8 * channel_count;
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                reference(w, channel_info_start + c * 0x38);
+            }
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                reference(w, channel_info_start + c * 0x38 + 8);
+                // zeros for PCM streams
+                const auto coefs = c < d.coefs.size() ? d.coefs[c] : dsp_adpcm::coefficients{};
+                const auto hist  = c < d.block_histories.size() ? d.block_histories[c][0] : dsp_adpcm::history{};
+                for (const auto& pair : coefs.pairs)
+                {
+                    w << pair[0] << pair[1];
+                }
+                w << uint16_t(0) << uint16_t(0) << hist.previous << hist.before_previous
+                  << uint16_t(0) << uint16_t(0) << uint16_t(0) << uint16_t(0);
+            }
+        }
+
+        ostringstream adpc_stm;
+        {
+            auto w = file_writer(adpc_stm, little_endian);
+            for (size_t b = 0; b < block_count; ++b)
+            {
+                for (size_t c = 0; c < channel_count && d.enc == encoding::adpcm; ++c)
+                {
+                    w << d.block_histories[c][b].previous << d.block_histories[c][b].before_previous;
+                }
+            }
+        }
+
+        ostringstream data_stm;
+        {
+            auto w = file_writer(data_stm, little_endian);
+            w << uint32_t(0x18);
+            pad(w, data_stm, 0x18);
+            for (size_t b = 0; b < block_count; ++b)
+            {
+                for (size_t c = 0; c < channel_count; ++c)
+                {
+                    const auto size = b + 1 < block_count ? d.block_size : last_padded;
+                    w.write_raw(d.channel_data[c].data() + b * d.block_size, size);
+                }
+            }
+        }
+
+        const auto head = section("HEAD", head_stm.str(), little_endian);
+        const auto adpc = section("ADPC", adpc_stm.str(), little_endian);
+        const auto data = section("DATA", data_stm.str(), little_endian);
+
+        ostringstream stm;
+        auto w = file_writer(stm, little_endian);
+        w.write_raw("RSTM", 4);
+        w << uint16_t(0xFEFF) << uint16_t(0x0100)
+          << uint32_t(0x40 + head.size() + adpc.size() + data.size())
+          << uint16_t(0x40) << uint16_t(2)
+          << uint32_t(0x40) << uint32_t(head.size())
+          << uint32_t(0x40 + head.size()) << uint32_t(adpc.size())
+          << uint32_t(0x40 + head.size() + adpc.size()) << uint32_t(data.size());
+        pad(w, stm, 0x40);
+        return stm.str() + head + adpc + data;
+    }
+
+    /**
+     * A DSP-ADPCM stream of random frames, along with the samples decoded
+     * from start to end in one go.
+     */
+    rstm_description make_adpcm_description(const size_t channel_count, const uint32_t block_count,
+                                             const uint32_t last_block_samples,
+                                             vector<vector<int16_t>>& expected)
+    {
+        uint32_t seed = 46;
+        const auto next_random = [&seed]() { return seed = seed * 1103515245u + 12345u, seed >> 8; };
+
+        rstm_description d;
+        d.block_size    = 0x20 * 4;
+        d.block_samples = d.block_size / dsp_adpcm::frame_size * dsp_adpcm::samples_per_frame;
+        d.sample_count  = (block_count - 1) * d.block_samples + last_block_samples;
+        d.adpc_entry_samples = d.block_samples;
+
+        expected.assign(channel_count, vector<int16_t>(d.sample_count));
+        for (size_t c = 0; c < channel_count; ++c)
+        {
+            string frames(block_count * d.block_size, '\0');
+            for (size_t i = 0; i < frames.size(); ++i)
+            {
+                frames[i] = static_cast<char>(i % dsp_adpcm::frame_size == 0 ? next_random() & 0x7F : next_random());
+            }
+            dsp_adpcm::coefficients coefs;
+            for (auto& pair : coefs.pairs)
+            {
+                pair[0] = static_cast<int16_t>(next_random() % 4096);
+                pair[1] = static_cast<int16_t>(next_random() % 4096 - 2048);
+            }
+
+            // the history at the start of each block, as the encoder records it
+            dsp_adpcm::history hist;
+            hist.previous = static_cast<int16_t>(c * 100);
+            vector<dsp_adpcm::history> histories;
+            for (uint32_t b = 0; b < block_count; ++b)
+            {
+                histories.push_back(hist);
+                const auto samples = b + 1 < block_count ? d.block_samples : last_block_samples;
+                dsp_adpcm::decode(frames.data() + b * d.block_size, samples, coefs, hist,
+                                  expected[c].data() + b * d.block_samples);
+            }
+
+            d.channel_data.push_back(move(frames));
+            d.coefs.push_back(coefs);
+            d.block_histories.push_back(move(histories));
+        }
+        return d;
+    }
+
+    /**
+     * Reads frames from the player until it has read frame_count or the
+     * stream has finished, by channel.
+     */
+    vector<vector<int16_t>> read_from(player& p, const size_t channel_count, const size_t frame_count)
+    {
+        vector<vector<int16_t>> result(channel_count);
+        vector<int16_t> buffers(channel_count * 64);
+        vector<int16_t*> channels;
+        for (size_t c = 0; c < channel_count; ++c)
+        {
+            channels.push_back(buffers.data() + c * 64);
+        }
+
+        while (result[0].size() < frame_count && !p.finished())
+        {
+            const auto copied = p.read(channels.data(), min<size_t>(64, frame_count - result[0].size()));
+            for (size_t c = 0; c < channel_count; ++c)
+            {
+                result[c].insert(result[c].end(), channels[c], channels[c] + copied);
+            }
+            if (copied == 0)
+            {
+                this_thread::yield();
+            }
+        }
+        return result;
+    }
+
+    vector<int16_t> samples_of(const pcm16_audio_data& audio, const size_t channel)
+    {
+        return vector<int16_t>(audio.channel(channel), audio.channel(channel) + audio.frame_count());
+    }
+}
+
+TEST(stream, stream_info)
+{
+    vector<vector<int16_t>> expected;
+    auto d = make_adpcm_description(2, 3, 20, expected);
+    d.loops      = true;
+    d.loop_start = 100;
+
+    istringstream stm(make_rstm(d, false));
+    const auto rstm = stream::make_stream(stm);
+    EXPECT_EQ(encoding::adpcm, rstm.stream_encoding());
+    EXPECT_EQ(2u, rstm.channel_count());
+    EXPECT_EQ(32000, rstm.sample_rate());
+    EXPECT_EQ(224u * 2 + 20, rstm.sample_count());
+    EXPECT_TRUE(rstm.loops());
+    EXPECT_EQ(100u, rstm.loop_start());
+    EXPECT_EQ(3u, rstm.block_count());
+    EXPECT_EQ(224u, rstm.block_samples());
+    EXPECT_EQ(d.coefs[1].pairs[7][1], rstm.coefficients(1).pairs[7][1]);
+}
+
+TEST(stream, decode_matches_decoding_from_start)
+{
+    for (const auto little_endian : { false, true })
+    {
+        vector<vector<int16_t>> expected;
+        const auto d = make_adpcm_description(3, 40, 15, expected);
+
+        istringstream stm(make_rstm(d, little_endian));
+        const auto rstm = stream::make_stream(stm);
+
+        for (const auto mode : { stream::decoding::serial, stream::decoding::parallel })
+        {
+            const auto audio = rstm.decode(mode);
+            ASSERT_EQ(3u, audio.channel_count());
+            ASSERT_EQ(d.sample_count, audio.frame_count());
+            for (size_t c = 0; c < 3; ++c)
+            {
+                EXPECT_EQ(expected[c], samples_of(audio, c));
+            }
+        }
+    }
+}
+
+TEST(stream, pcm_encodings)
+{
+    for (const auto little_endian : { false, true })
+    {
+        rstm_description d;
+        d.enc           = encoding::pcm16;
+        d.block_size    = 0x20;
+        d.block_samples = 0x10;
+        d.sample_count  = 0x18;
+
+        ostringstream samples;
+        {
+            auto w = file_writer(samples, little_endian);
+            for (int16_t i = 0; i < 0x20; ++i)
+            {
+                w << int16_t(i * 1000 - 16000);
+            }
+        }
+        d.channel_data.push_back(samples.str());
+
+        istringstream stm(make_rstm(d, little_endian));
+        const auto audio = stream::make_stream(stm).decode();
+        ASSERT_EQ(0x18u, audio.frame_count());
+        EXPECT_EQ(-16000, audio.channel(0)[0]);
+        EXPECT_EQ(0x17 * 1000 - 16000, audio.channel(0)[0x17]);
+    }
+
+    {   // 8-bit samples take the high byte
+        rstm_description d;
+        d.enc           = encoding::pcm8;
+        d.block_size    = 0x20;
+        d.block_samples = 0x20;
+        d.sample_count  = 0x21;
+        d.channel_data.push_back(string(0x40, '\x80'));
+        d.channel_data.back()[0x20] = 0x7F;
+
+        istringstream stm(make_rstm(d, false));
+        const auto audio = stream::make_stream(stm).decode(stream::decoding::parallel);
+        EXPECT_EQ(-32768, audio.channel(0)[0]);
+        EXPECT_EQ(0x7F00, audio.channel(0)[0x20]);
+    }
+}
+
+TEST(stream, integrity_errors)
+{
+    vector<vector<int16_t>> expected;
+    const auto d = make_adpcm_description(1, 2, 14, expected);
+
+    {   // Test 1: file magic
+        auto content = make_rstm(d, false);
+        content[0] = 'S';
+        istringstream stm(content);
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 2: ADPC entries that are not per block
+        auto bad = d;
+        bad.adpc_entry_samples = d.block_samples * 2;
+        istringstream stm(make_rstm(bad, false));
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 3: loop past the end
+        auto bad = d;
+        bad.loops      = true;
+        bad.loop_start = d.sample_count;
+        istringstream stm(make_rstm(bad, false));
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 4: blocks too small for their samples
+        auto bad = d;
+        bad.block_samples += dsp_adpcm::samples_per_frame;
+        bad.adpc_entry_samples = bad.block_samples;
+        istringstream stm(make_rstm(bad, false));
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 5: ADPC entries that are not one history per channel
+        auto bad = d;
+        bad.adpc_entry_size = 8;
+        istringstream stm(make_rstm(bad, false));
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 6: ADPC section too short for the histories of every block
+        auto content = make_rstm(d, false);
+        ostringstream length_stm;
+        auto w = file_writer(length_stm);
+        w << uint32_t(8);
+        const auto length = length_stm.str();
+
+        // in the file header and in the section itself
+        content.replace(0x1C, 4, length);
+        content.replace(content.find("ADPC") + 4, 4, length);
+        istringstream stm(content);
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 7: a single block of no samples, with all samples in the last block
+        vector<vector<int16_t>> one_block_expected;
+        auto content = make_rstm(make_adpcm_description(1, 1, 14, one_block_expected), false);
+
+        // samples per block and per ADPC entry in the stream information
+        content.replace(0x7C, 4, 4, '\0');
+        content.replace(0x8C, 4, 4, '\0');
+        istringstream stm(content);
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+
+    {   // Test 8: block sizes whose total over all channels wraps around
+        rstm_description pcm;
+        pcm.enc           = encoding::pcm16;
+        pcm.block_size    = 0x20;
+        pcm.block_samples = 0x10;
+        pcm.sample_count  = 0x10;
+        pcm.channel_data.assign(16, string(0x20, '\0'));
+        auto content = make_rstm(pcm, false);
+
+        // 16 * (2^28 * (2^32 - 1) + 2^28 + 1) is 16 modulo 2^64
+        const auto set = [&content](const size_t offset, const uint32_t value)
+        {
+            ostringstream value_stm;
+            auto w = file_writer(value_stm);
+            w << value;
+            content.replace(offset, 4, value_stm.str());
+        };
+        set(0x6C, (uint32_t(1) << 28) * 15 + 14);   // sample count
+        set(0x74, (uint32_t(1) << 28) + 1);         // block count
+        set(0x78, 0xFFFFFFFF);                      // block size
+        set(0x7C, 15);                              // block samples
+        set(0x80, 28);                              // last block size
+        set(0x84, 14);                              // last block samples
+        set(0x88, (uint32_t(1) << 28) + 1);         // last block padded size
+        istringstream stm(content);
+        EXPECT_THROW(stream::make_stream(stm), integrity_error);
+    }
+}
+
+TEST(stream, cursor_seeks_within_blocks)
+{
+    vector<vector<int16_t>> expected;
+    const auto d = make_adpcm_description(2, 10, 30, expected);
+
+    istringstream stm(make_rstm(d, false));
+    const auto rstm = stream::make_stream(stm);
+    stream::cursor cursor(rstm);
+
+    {   // Test 1: reads stop at block boundaries
+        const auto first = cursor.read(1000);
+        EXPECT_EQ(rstm.block_samples(), first.frame_count());
+        EXPECT_EQ(rstm.block_samples(), cursor.tell());
+
+        cursor.seek(d.sample_count - 1);
+        const auto last = cursor.read(5);
+        EXPECT_EQ(1u, last.frame_count());
+        EXPECT_EQ(expected[1].back(), last.channel(1)[0]);
+        EXPECT_EQ(d.sample_count, cursor.tell());
+        EXPECT_EQ(0u, cursor.read(5).frame_count());
+    }
+
+    {   // Test 2: samples after any seek match decoding from the start
+        for (const size_t target : { size_t(0), size_t(1), size_t(13), size_t(14), size_t(223), size_t(224),
+                                     size_t(1000), size_t(5 * 224 + 101), size_t(d.sample_count - 30) })
+        {
+            cursor.seek(target);
+            vector<int16_t> left, right;
+            while (left.size() < 300)
+            {
+                const auto samples = cursor.read(300 - left.size());
+                if (samples.frame_count() == 0)
+                {
+                    break;
+                }
+                left.insert(left.end(), samples.channel(0), samples.channel(0) + samples.frame_count());
+                right.insert(right.end(), samples.channel(1), samples.channel(1) + samples.frame_count());
+            }
+
+            const auto end = min<size_t>(target + 300, d.sample_count);
+            EXPECT_EQ(vector<int16_t>(expected[0].begin() + target, expected[0].begin() + end), left) << target;
+            EXPECT_EQ(vector<int16_t>(expected[1].begin() + target, expected[1].begin() + end), right) << target;
+        }
+    }
+
+    {   // Test 3: seeking within the block decoded last reuses it
+        cursor.seek(300);
+        const auto first = cursor.read(10);
+        cursor.seek(250);
+        const auto second = cursor.read(10);
+        EXPECT_EQ(first.channel(0) - 50, second.channel(0));
+    }
+
+    EXPECT_THROW(cursor.seek(d.sample_count + 1), out_of_range);
+}
+
+TEST(stream, cursor_restarts_at_loop_start)
+{
+    vector<vector<int16_t>> expected;
+    auto d = make_adpcm_description(1, 4, 100, expected);
+    d.loops      = true;
+    d.loop_start = 400;
+
+    istringstream stm(make_rstm(d, false));
+    const auto rstm = stream::make_stream(stm);
+    stream::cursor cursor(rstm);
+
+    cursor.seek(d.sample_count - 10);
+    EXPECT_EQ(10u, cursor.read_looping(50).frame_count());
+
+    const auto looped = cursor.read_looping(50);
+    ASSERT_EQ(48u, looped.frame_count());   // to the end of the block the loop starts in
+    EXPECT_EQ(vector<int16_t>(expected[0].begin() + 400, expected[0].begin() + 448),
+              vector<int16_t>(looped.channel(0), looped.channel(0) + 48));
+    EXPECT_EQ(448u, cursor.tell());
+}
+
+TEST(stream, player_reads_to_the_end)
+{
+    vector<vector<int16_t>> expected;
+    const auto d = make_adpcm_description(2, 12, 77, expected);
+
+    istringstream stm(make_rstm(d, false));
+    const auto rstm = stream::make_stream(stm);
+
+    player::buffering buffering;
+    buffering.read_ahead_frames = 500;
+    buffering.slice_frames      = 100;
+    player p(rstm, buffering, 10);
+
+    EXPECT_EQ(vector<int16_t>(expected[0].begin() + 10, expected[0].end()), read_from(p, 2, d.sample_count)[0]);
+    EXPECT_TRUE(p.finished());
+    EXPECT_EQ(nullptr, p.error());
+    EXPECT_EQ(0u, p.fill_level());
+
+    // silence past the end, which is not an underrun
+    const auto underruns = p.underruns();
+    int16_t left[4] = { 1, 1, 1, 1 }, right[4] = { 1, 1, 1, 1 };
+    int16_t* const channels[] = { left, right };
+    EXPECT_EQ(0u, p.read(channels, 4));
+    EXPECT_EQ(0, left[3]);
+    EXPECT_EQ(underruns, p.underruns());
+}
+
+TEST(stream, player_loops_and_counts_underruns)
+{
+    vector<vector<int16_t>> expected;
+    auto d = make_adpcm_description(1, 4, 100, expected);
+    d.loops      = true;
+    d.loop_start = 400;
+
+    istringstream stm(make_rstm(d, false));
+    const auto rstm = stream::make_stream(stm);
+
+    {   // Test 1: continues from the loop start after the end
+        player p(rstm);
+        const auto samples = read_from(p, 1, d.sample_count + 300)[0];
+        ASSERT_EQ(d.sample_count + 300, samples.size());
+        EXPECT_EQ(vector<int16_t>(expected[0].begin() + 400, expected[0].begin() + 700),
+                  vector<int16_t>(samples.begin() + d.sample_count, samples.end()));
+        EXPECT_FALSE(p.finished());
+    }
+
+    {   // Test 2: reading more than is read ahead underruns
+        player::buffering buffering;
+        buffering.read_ahead_frames = 200;
+        buffering.slice_frames      = 50;
+        player p(rstm, buffering);
+        while (p.fill_level() < 200)
+        {
+            this_thread::yield();
+        }
+
+        vector<int16_t> samples(1000, 1);
+        int16_t* const channels[] = { samples.data() };
+        EXPECT_EQ(200u, p.read(channels, 1000));
+        EXPECT_EQ(1u, p.underruns());
+        EXPECT_EQ(expected[0][199], samples[199]);
+        EXPECT_EQ(0, samples[999]);
+
+        // looping without the stream looping stops at the end
+        player once(rstm, buffering, d.sample_count - 5, false);
+        EXPECT_EQ(5u, read_from(once, 1, 100)[0].size());
+        EXPECT_TRUE(once.finished());
+    }
+
+    EXPECT_THROW(player(rstm, player::buffering(), d.sample_count + 1), out_of_range);
+}
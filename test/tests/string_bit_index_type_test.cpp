@@ -362,3 +362,46 @@ TEST(string_bit_index_test, indexing)
     EXPECT_EQ(0, idx_type{22}[s]);  EXPECT_EQ(0, idx_type{30}[s]);
     EXPECT_EQ(0, idx_type{23}[s]);  EXPECT_EQ(0, idx_type{31}[s]);
 }
+
+/**
+ * Tests that wider index types address characters past the 8191 addressable
+ * by a 16-bit index, and keep the raw values of narrower ones.
+ */
+TEST(string_bit_index_test, wide_index_types)
+{
+    {   // Test 1: masks
+        EXPECT_TRUE(0xFFFFu == string_bit_index_type<uint16_t>::max);
+        EXPECT_TRUE(0xFFFFFFFFu == string_bit_index_type<uint32_t>::max);
+        EXPECT_TRUE(0xFFFFFFFFFFFFFFFFu == string_bit_index_type<uint64_t>::max);
+
+        EXPECT_TRUE(8191 == string_bit_index_type<uint16_t>::max_string_length);
+        EXPECT_TRUE(0x1FFFFFFFu == string_bit_index_type<uint32_t>::max_string_length);
+        EXPECT_TRUE(0x1FFFFFFFFFFFFFFFu == string_bit_index_type<uint64_t>::max_string_length);
+    }
+
+    {   // Test 2: the same raw value addresses the same bit
+        const string_bit_index_type<uint16_t> narrow(8 * 100 + 5);
+        const string_bit_index_type<uint32_t> wide(8 * 100 + 5);
+        const string_bit_index_type<uint64_t> wider(8 * 100 + 5);
+        EXPECT_EQ(100u, narrow.char_index);   EXPECT_EQ(5u, narrow.bit_index);
+        EXPECT_EQ(100u, wide.char_index);     EXPECT_EQ(5u, wide.bit_index);
+        EXPECT_EQ(100u, wider.char_index);    EXPECT_EQ(5u, wider.bit_index);
+    }
+
+    {   // Test 3: assigning fields past 16 bits
+        string_bit_index_type<uint32_t> wide;
+        wide.char_index = 100000;
+        wide.bit_index  = 7;
+        EXPECT_EQ(8u * 100000 + 7, wide.index);
+
+        string s(100001, '\0');
+        s[100000] = 1;
+        EXPECT_EQ(1, wide[s]);
+        EXPECT_EQ(0, string_bit_index_type<uint32_t>(8u * 100000 + 6)[s]);
+
+        string_bit_index_type<uint64_t> wider;
+        wider.char_index = uint64_t(1) << 40;
+        wider.bit_index  = 3;
+        EXPECT_EQ((uint64_t(1) << 43) + 3, wider.index);
+    }
+}
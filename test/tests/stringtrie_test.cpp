@@ -4,6 +4,9 @@
 #include <initializer_list>
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 using namespace ::testing;
 using namespace brtools::trie;
@@ -41,6 +44,17 @@ TEST(stringtrie_test, insert_and_find_id)
     }
 }
 
+TEST(stringtrie_test, find_string_ref)
+{
+    stringtrie st = {"foo", "bar", ""};
+    EXPECT_EQ("foo", st.find_string_ref(st.find_id("foo")));
+    EXPECT_EQ("bar", st.find_string_ref(st.find_id("bar")));
+    EXPECT_TRUE(st.find_string_ref(st.find_id("")).empty());
+
+    EXPECT_THROW(st.find_string_ref(stringtrie::invalid), invalid_argument);
+    EXPECT_THROW(st.find_string_ref(3), out_of_range);
+}
+
 TEST(stringtrie_test, initializer_list_constructor)
 {
     const initializer_list<string>& init_list = {"foo", "bar", 
@@ -67,5 +81,319 @@ TEST(stringtrie_test, unsuccessful_finds)
         EXPECT_EQ(stringtrie::invalid, st.find_id("bar"));
         EXPECT_EQ(stringtrie::invalid, st.find_id(""));
     }
+
+    {   // Test 3: strings sharing the tested bits with a stored string are not found
+        st.insert("foo");
+        st.insert("bar");
+        EXPECT_EQ(stringtrie::invalid, st.find_id("baz"));
+        EXPECT_EQ(stringtrie::invalid, st.find_id("fo"));
+        EXPECT_EQ(stringtrie::invalid, st.find_id("foobar"));
+        EXPECT_EQ(stringtrie::invalid, st.find_id(""));
+    }
+}
+
+TEST(stringtrie_test, find_id_of_character_range)
+{
+    const stringtrie st = {"foo", "bar", "foobar", "barfoo", "foobarfoo", "barfoobar"};
+    const char buffer[] = "barfoobarbaz";
+
+    const auto barfoo    = st.find_id(buffer, 6);
+    const auto barfoobar = st.find_id(buffer, 9);
+    const auto missing   = st.find_id(buffer, 12);
+
+    EXPECT_EQ("barfoo",    st.find_string(barfoo));
+    EXPECT_EQ("barfoobar", st.find_string(barfoobar));
+    EXPECT_EQ(stringtrie::invalid, missing);
+}
+
+
+TEST(stringtrie_test, many_strings)
+{
+    // strings sharing long prefixes, and differing in bits of all positions
+    vector<string> strs;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        strs.push_back("symbol_" + to_string(i * 7919 % 5000));
+        strs.back().push_back(static_cast<char>(0x80 | i % 0x80));
+    }
+
+    stringtrie st;
+    vector<stringtrie::string_id_type> ids;
+    for (const auto& str : strs)
+    {
+        ids.push_back(st.insert(str));
+    }
+
+    for (size_t i = 0; i < strs.size(); ++i)
+    {
+        EXPECT_EQ(ids[i],  st.find_id(strs[i]));
+        EXPECT_EQ(strs[i], st.find_string(ids[i]));
+    }
+}
+
+TEST(stringtrie_test, long_strings)
+{
+    // strings differing before, at and after word boundaries, and in length
+    const string base = "sound/stream/bgm/stage_01/intro_loop_variation.brstm";
+    vector<string> strs{ base, base.substr(0, 7), base.substr(0, 8), base.substr(0, 9), base + base };
+    for (const size_t position : { 0, 7, 8, 15, 16, 31, 40, 51 })
+    {
+        for (const char flip : { '\x01', '\x80' })
+        {
+            strs.push_back(base);
+            strs.back()[position] ^= flip;
+        }
+    }
+
+    stringtrie st;
+    vector<stringtrie::string_id_type> ids;
+    for (const auto& str : strs)
+    {
+        ids.push_back(st.insert(str));
+    }
+
+    for (size_t i = 0; i < strs.size(); ++i)
+    {
+        EXPECT_EQ(ids[i],  st.find_id(strs[i]));
+        EXPECT_EQ(ids[i],  st.insert(strs[i]));
+        EXPECT_EQ(strs[i], st.find_string(ids[i]));
+    }
+}
+
+TEST(stringtrie_test, bulk_construction)
+{
+    vector<string> strs;
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        strs.push_back("path/" + to_string(i * 7919 % 1000) + "/" + to_string(i % 7));
+        strs.back().push_back(static_cast<char>(0x80 | i % 0x80));
+    }
+    strs.push_back("");
+    strs.push_back(strs.front());   // repeated
+
+    {   // Test 1: unsorted strings get the ids insertion would give them
+        stringtrie inserted;
+        vector<stringtrie::string_id_type> ids;
+        for (const auto& str : strs)
+        {
+            ids.push_back(inserted.insert(str));
+        }
+
+        const stringtrie bulk(vector<brtools::util::string_ref>(strs.begin(), strs.end()));
+        for (size_t i = 0; i < strs.size(); ++i)
+        {
+            EXPECT_EQ(ids[i],  bulk.find_id(strs[i]));
+            EXPECT_EQ(strs[i], bulk.find_string(ids[i]));
+        }
+        EXPECT_EQ(stringtrie::invalid, bulk.find_id("path/"));
+    }
+
+    {   // Test 2: presorted strings
+        auto sorted = strs;
+        sort(sorted.begin(), sorted.end(), [](const string& lhs, const string& rhs)
+                                           {   return brtools::util::string_ref(lhs) < rhs;   });
+
+        stringtrie bulk(vector<brtools::util::string_ref>(sorted.begin(), sorted.end()),
+                        stringtrie::key_order::sorted);
+        for (const auto& str : strs)
+        {
+            EXPECT_EQ(str, bulk.find_string(bulk.find_id(str)));
+        }
+
+        // the trie can be inserted into afterwards
+        const auto id = bulk.insert("path/1000");
+        EXPECT_EQ(id, bulk.find_id("path/1000"));
+    }
+}
+
+TEST(stringtrie_test, find_ids)
+{
+    vector<string> strs;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        strs.push_back("symbol_" + to_string(i * 7919 % 1000));
+    }
+    const stringtrie st(vector<brtools::util::string_ref>(strs.begin(), strs.end()));
+
+    // found and missing keys, in a number that is not a multiple of any group size
+    vector<string> keys;
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        keys.push_back(i % 3 == 0 ? "missing_" + to_string(i) : strs[i * 31 % strs.size()]);
+    }
+    const vector<brtools::util::string_ref> key_refs(keys.begin(), keys.end());
+
+    {   // Test 1: same ids as looking up one at a time
+        const auto ids = st.find_ids(key_refs);
+        ASSERT_EQ(keys.size(), ids.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            EXPECT_EQ(st.find_id(keys[i]), ids[i]);
+        }
+    }
+
+    {   // Test 2: caller-provided storage
+        vector<stringtrie::string_id_type> ids(keys.size());
+        st.find_ids(key_refs.data(), key_refs.size(), ids.data());
+        EXPECT_EQ(stringtrie::invalid, ids[0]);
+        EXPECT_EQ(st.find_id(keys[1]), ids[1]);
+    }
+
+    {   // Test 3: empty trie
+        const stringtrie empty;
+        EXPECT_EQ(vector<stringtrie::string_id_type>(2, stringtrie::invalid), empty.find_ids({ "foo", "" }));
+    }
 }
 
+TEST(stringtrie_test, prefix_enumeration)
+{
+    const stringtrie st = {"SEQ_BGM_TITLE", "SEQ_SE_JUMP", "SEQ_BGM_STAGE_1", "STRM_BGM",
+                           "SEQ_BGM_STAGE_2", "SEQ_BGM_", "SEQ", ""};
+
+    const auto collect = [&st](const string& prefix, const size_t limit)
+    {
+        vector<string> result;
+        const auto completed = st.for_each_with_prefix(prefix,
+            [&](const stringtrie::string_id_type id, const brtools::util::string_ref str)
+            {
+                EXPECT_EQ(id, st.find_id(str.str()));
+                result.push_back(str.str());
+                return result.size() < limit;
+            });
+        EXPECT_EQ(result.size() < limit, completed);
+        return result;
+    };
+
+    {   // Test 1: matching strings in lexicographic order
+        const vector<string> expected{ "SEQ_BGM_", "SEQ_BGM_STAGE_1", "SEQ_BGM_STAGE_2", "SEQ_BGM_TITLE" };
+        EXPECT_EQ(expected, collect("SEQ_BGM_", 100));
+        EXPECT_EQ(expected, collect("SEQ_BGM", 100));
+    }
+
+    {   // Test 2: no matches
+        EXPECT_TRUE(collect("SEQ_BGM_X", 100).empty());
+        EXPECT_TRUE(collect("WAVE", 100).empty());
+        EXPECT_TRUE(collect("SEQ_BGM_TITLE_", 100).empty());
+    }
+
+    {   // Test 3: early termination
+        EXPECT_EQ(vector<string>({ "SEQ_BGM_", "SEQ_BGM_STAGE_1" }), collect("SEQ_BGM_", 2));
+    }
+
+    {   // Test 4: all strings
+        vector<string> all;
+        EXPECT_TRUE(st.for_each([&all](stringtrie::string_id_type, const brtools::util::string_ref str)
+                                {   all.push_back(str.str()); return true;   }));
+        const vector<string> expected{ "", "SEQ", "SEQ_BGM_", "SEQ_BGM_STAGE_1", "SEQ_BGM_STAGE_2",
+                                       "SEQ_BGM_TITLE", "SEQ_SE_JUMP", "STRM_BGM" };
+        EXPECT_EQ(expected, all);
+        EXPECT_EQ(expected, collect("", 100));
+    }
+
+    {   // Test 5: empty trie
+        EXPECT_TRUE(stringtrie().for_each([](stringtrie::string_id_type, brtools::util::string_ref)
+                                          {   ADD_FAILURE(); return true;   }));
+    }
+}
+
+TEST(stringtrie_test, erase)
+{
+    stringtrie st = {"SEQ_BGM_TITLE", "SEQ_SE_JUMP", "SEQ_BGM_STAGE_1", "STRM_BGM", "SEQ_BGM_STAGE_2"};
+    const auto stage_1 = st.find_id("SEQ_BGM_STAGE_1");
+
+    {   // Test 1: erased strings are gone, the others remain
+        EXPECT_EQ(stage_1, st.erase("SEQ_BGM_STAGE_1"));
+        EXPECT_EQ(stringtrie::invalid, st.find_id("SEQ_BGM_STAGE_1"));
+        EXPECT_THROW(st.find_string(stage_1), out_of_range);
+        for (const auto& str : { "SEQ_BGM_TITLE", "SEQ_SE_JUMP", "STRM_BGM", "SEQ_BGM_STAGE_2" })
+        {
+            EXPECT_EQ(str, st.find_string(st.find_id(str)));
+        }
+    }
+
+    {   // Test 2: strings not in the trie
+        EXPECT_EQ(stringtrie::invalid, st.erase("SEQ_BGM_STAGE_1"));
+        EXPECT_EQ(stringtrie::invalid, st.erase("SEQ_BGM_STAGE_"));
+        EXPECT_EQ(stringtrie::invalid, stringtrie().erase("SEQ"));
+    }
+
+    {   // Test 3: the id is reused
+        EXPECT_EQ(stage_1, st.insert("SEQ_BGM_STAGE_3"));
+        EXPECT_EQ("SEQ_BGM_STAGE_3", st.find_string(stage_1));
+    }
+
+    {   // Test 4: erasing everything
+        for (const auto& str : { "SEQ_BGM_TITLE", "SEQ_SE_JUMP", "STRM_BGM", "SEQ_BGM_STAGE_2", "SEQ_BGM_STAGE_3" })
+        {
+            EXPECT_NE(stringtrie::invalid, st.erase(str));
+        }
+        EXPECT_TRUE(st.for_each([](stringtrie::string_id_type, brtools::util::string_ref)
+                                {   ADD_FAILURE(); return true;   }));
+        EXPECT_EQ(stringtrie::invalid, st.find_id("SEQ_SE_JUMP"));
+        EXPECT_EQ(0u, st.insert("WAVE"));
+    }
+}
+
+TEST(stringtrie_test, erase_churn)
+{
+    // loads and unloads overlapping sets of strings, as a process going
+    // through archives would; ids stay within the largest set
+    const size_t set_size = 500;
+    stringtrie st;
+    map<string, stringtrie::string_id_type> expected;
+    for (size_t round = 0; round < 20; ++round)
+    {
+        for (size_t i = 0; i < set_size; ++i)
+        {
+            const auto str = "archive_" + to_string(round * set_size / 2 + i) + "_sound";
+            if (expected.count(str) == 0)
+            {
+                const auto id = st.insert(str);
+                EXPECT_LT(id, 2 * set_size);
+                expected[str] = id;
+            }
+        }
+
+        // unloads the older half
+        for (auto it = expected.begin(); it != expected.end(); )
+        {
+            const auto number = stoul(it->first.substr(it->first.find('_') + 1));
+            if (number < (round + 1) * set_size / 2)
+            {
+                EXPECT_EQ(it->second, st.erase(it->first));
+                it = expected.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (const auto& entry : expected)
+        {
+            ASSERT_EQ(entry.second, st.find_id(entry.first));
+            ASSERT_EQ(entry.first, st.find_string(entry.second));
+        }
+    }
+}
+
+TEST(stringtrie_test, keys_longer_than_16_bit_index)
+{
+    // differ only past the 8191 characters a 16-bit index addresses
+    const string prefix(10000, 'a');
+    const string str1 = prefix + "/bgm";
+    const string str2 = prefix + "/se";
+
+    stringtrie st;
+    const auto id1 = st.insert(str1);
+    const auto id2 = st.insert(str2);
+    EXPECT_NE(id1, id2);
+    EXPECT_EQ(id1, st.find_id(str1));
+    EXPECT_EQ(id2, st.find_id(str2));
+    EXPECT_EQ(stringtrie::invalid, st.find_id(prefix));
+
+    const stringtrie bulk({ str2, str1, prefix });
+    EXPECT_EQ(0u, bulk.find_id(str2));
+    EXPECT_EQ(1u, bulk.find_id(str1));
+    EXPECT_EQ(2u, bulk.find_id(prefix));
+}
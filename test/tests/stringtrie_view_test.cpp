@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <brtools/trie/stringtrie.h>
+#include <brtools/trie/stringtrie_view.h>
+#include <brtools/error/integrity_error.h>
+#include <brtools/io/stream_parser.h>
+#include <brtools/io/stream_writer.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace brtools::trie;
+using namespace brtools::io;
+using namespace std;
+using brtools::error::integrity_error;
+
+namespace
+{
+    /**
+     * Whether values are to be reversed to be big endian, as in BR files.
+     */
+    bool little_endian_machine()
+    {
+        const uint16_t one = 1;
+        return *reinterpret_cast<const char*>(&one) == 1;
+    }
+
+    /**
+     * SYMB data with the strings "a" and "b", which differ first at bit 6.
+     */
+    const auto SYMB_CONTENT =
+/* 00 */ "\x00\x00\x00\x08"                 // offset to string table
+/* 04 */ "\x00\x00\x00\x18"                 // offset to tree
+/* 08 */ "\x00\x00\x00\x02"                 // number of strings: 2
+/* 0C */ "\x00\x00\x00\x14"                 // offset to string 0
+/* 10 */ "\x00\x00\x00\x16"                 // offset to string 1
+/* 14 */ "a\0"                              // string 0
+/* 16 */ "b\0"                              // string 1
+/* 18 */ "\x00\x00\x00\x00"                 // root node index
+/* 1C */ "\x00\x00\x00\x03"                 // number of nodes: 3
+/* 20 */ "\x00\x00" "\x00\x06"              // node 0: branch at bit 6
+         "\x00\x00\x00\x01" "\x00\x00\x00\x02"  //     left: 1, right: 2
+         "\xFF\xFF\xFF\xFF" "\xFF\xFF\xFF\xFF"
+/* 34 */ "\x00\x01" "\xFF\xFF"              // node 1: leaf
+         "\xFF\xFF\xFF\xFF" "\xFF\xFF\xFF\xFF"
+         "\x00\x00\x00\x00" "\x00\x00\x00\x0A"  //     string 0, item 10
+/* 48 */ "\x00\x01" "\xFF\xFF"              // node 2: leaf
+         "\xFF\xFF\xFF\xFF" "\xFF\xFF\xFF\xFF"
+         "\x00\x00\x00\x01" "\x00\x00\x00\x0B"  //     string 1, item 11
+/* 5C */ ""s;
+}
+
+TEST(stringtrie_view, lookups)
+{
+    const stringtrie_view view(SYMB_CONTENT.data(), SYMB_CONTENT.size());
+
+    EXPECT_EQ(0u,   view.find_id("a"));
+    EXPECT_EQ(1u,   view.find_id("b"));
+    EXPECT_EQ(10u,  view.find_item_id("a"));
+    EXPECT_EQ(11u,  view.find_item_id("b"));
+    EXPECT_EQ("a",  view.find_string(0));
+    EXPECT_EQ("b",  view.find_string(1));
+
+    EXPECT_EQ(stringtrie_view::invalid, view.find_id("c"));
+    EXPECT_EQ(stringtrie_view::invalid, view.find_id("ab"));
+    EXPECT_EQ(stringtrie_view::invalid, view.find_item_id(""));
+    EXPECT_THROW(view.find_string(2), out_of_range);
+}
+
+TEST(stringtrie_view, malformed_data)
+{
+    {   // Test 1: tree out of range
+        EXPECT_THROW(stringtrie_view(SYMB_CONTENT.data(), 0x30), integrity_error);
+    }
+
+    {   // Test 2: child index out of range
+        auto content = SYMB_CONTENT;
+        content[0x27] = '\x07';
+        const stringtrie_view view(content.data(), content.size());
+        EXPECT_THROW(view.find_id("a"), integrity_error);
+    }
+
+    {   // Test 3: a cycle back to the root
+        auto content = SYMB_CONTENT;
+        content[0x27] = '\x00';
+        const stringtrie_view view(content.data(), content.size());
+        EXPECT_THROW(view.find_id("a"), integrity_error);
+    }
+}
+
+TEST(stringtrie_symb, read)
+{
+    istringstream stm(SYMB_CONTENT);
+    stream_parser sp(stm);
+    if (little_endian_machine())
+    {
+        sp.reverse_byte_order();
+    }
+
+    stringtrie st = {"foo"};
+    sp >> st;
+
+    EXPECT_EQ(0u, sp.tell());
+    EXPECT_EQ(0u, st.find_id("a"));
+    EXPECT_EQ(1u, st.find_id("b"));
+    EXPECT_EQ(stringtrie::invalid, st.find_id("foo"));
+    EXPECT_EQ(2u, st.insert("c"));
+}
+
+TEST(stringtrie_symb, malformed_tree)
+{
+    const auto read = [](const string& content)
+    {
+        istringstream stm(content);
+        stream_parser sp(stm);
+        if (little_endian_machine())
+        {
+            sp.reverse_byte_order();
+        }
+
+        stringtrie st;
+        sp >> st;
+    };
+
+    {   // Test 1: a leaf below both sides of a branch
+        auto content = SYMB_CONTENT;
+        content[0x2B] = '\x01';
+        EXPECT_THROW(read(content), integrity_error);
+    }
+
+    {   // Test 2: a string in two leaves
+        auto content = SYMB_CONTENT;
+        content[0x57] = '\x00';
+        EXPECT_THROW(read(content), integrity_error);
+    }
+
+    {   // Test 3: a node count no tree could have
+        auto content = SYMB_CONTENT;
+        content.replace(0x1C, 4, "\xFF\xFF\xFF\xFF");
+        content[0x27] = '\x07';
+        EXPECT_THROW(read(content), exception);
+    }
+}
+
+TEST(stringtrie_symb, write_and_read_back)
+{
+    vector<string> strs;
+    for (size_t i = 0; i < 500; ++i)
+    {
+        strs.push_back("sound/" + to_string(i * 7919 % 500));
+    }
+    const stringtrie original(vector<brtools::util::string_ref>(strs.begin(), strs.end()));
+
+    ostringstream out;
+    {
+        stream_writer sw(out);
+        if (little_endian_machine())
+        {
+            sw.reverse_byte_order();
+        }
+        sw << original;
+    }
+    const auto content = out.str();
+
+    {   // Test 1: reading into a trie
+        istringstream stm(content);
+        stream_parser sp(stm);
+        if (little_endian_machine())
+        {
+            sp.reverse_byte_order();
+        }
+
+        stringtrie st;
+        sp >> st;
+        for (const auto& str : strs)
+        {
+            EXPECT_EQ(original.find_id(str), st.find_id(str));
+            EXPECT_EQ(str, st.find_string(st.find_id(str)));
+        }
+    }
+
+    {   // Test 2: viewing the bytes
+        const stringtrie_view view(content.data(), content.size());
+        for (const auto& str : strs)
+        {
+            EXPECT_EQ(original.find_id(str), view.find_id(str));
+            EXPECT_EQ(original.find_id(str), view.find_item_id(str));
+            EXPECT_EQ(str, view.find_string(view.find_id(str)));
+        }
+        EXPECT_EQ(stringtrie_view::invalid, view.find_id("sound/"));
+    }
+
+    {   // Test 3: empty trie
+        ostringstream empty_out;
+        stream_writer sw(empty_out);
+        if (little_endian_machine())
+        {
+            sw.reverse_byte_order();
+        }
+        sw << stringtrie();
+
+        const auto empty_content = empty_out.str();
+        const stringtrie_view view(empty_content.data(), empty_content.size());
+        EXPECT_EQ(stringtrie_view::invalid, view.find_id(""));
+    }
+
+    {   // Test 4: strings differing past the 16-bit bit index of the format
+        const string prefix(10000, 'a');
+        ostringstream long_out;
+        stream_writer sw(long_out);
+        EXPECT_THROW(sw << stringtrie({ prefix + "b", prefix + "c" }), length_error);
+    }
+}
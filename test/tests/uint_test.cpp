@@ -23,7 +23,7 @@ TEST_F(uint_test, standard_sizes)
         istringstream stm("\x42"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, sp.read<uint<8>>());
+        EXPECT_EQ(expected, sp.read<brtools::data::types::uint<8>>());
     }
 
     {   // Test 2: uint16_t
@@ -31,7 +31,7 @@ TEST_F(uint_test, standard_sizes)
         istringstream stm("\xBE\xEF"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, sp.read<uint<16>>());
+        EXPECT_EQ(expected, sp.read<brtools::data::types::uint<16>>());
     }
 
     {   // Test 3: uint32_t
@@ -39,7 +39,7 @@ TEST_F(uint_test, standard_sizes)
         istringstream stm("\xDE\xAD\xBE\xEF"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, sp.read<uint<32>>());
+        EXPECT_EQ(expected, sp.read<brtools::data::types::uint<32>>());
     }
 
     {   // Test 4: uint64_t
@@ -48,7 +48,7 @@ TEST_F(uint_test, standard_sizes)
                           "\xDE\xAD\xBE\xEF"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, (sp.read<uint<64>>()));
+        EXPECT_EQ(expected, (sp.read<brtools::data::types::uint<64>>()));
     }
 }
 
@@ -63,7 +63,7 @@ TEST_F(uint_test, non_standard_sizes)
         istringstream stm("\xAB\xCD\xEF"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, sp.read<uint<24>>());
+        EXPECT_EQ(expected, sp.read<brtools::data::types::uint<24>>());
     }
 
     { // Test 2: uint<56>
@@ -71,6 +71,6 @@ TEST_F(uint_test, non_standard_sizes)
         istringstream stm("\x01\xDD\xAD\xC0\x01\xC0\xDE"s);
         stream_parser sp = parser(stm);
 
-        EXPECT_EQ(expected, sp.read<uint<56>>());
+        EXPECT_EQ(expected, sp.read<brtools::data::types::uint<56>>());
     }
 }
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <sstream>
+#include <thread>
 #include <brtools/data/types/variable.h>
 #include <brtools/io/stream_parser.h>
 #include <fixtures/stream_parser_fixture.h>
@@ -10,7 +11,19 @@ using namespace brtools::data::types;
 using namespace std;
 
 using brtools::io::stream_parser;
-using variable_test = stream_parser_fixture;
+
+/**
+ * Resets the variable memory after each test, so that it is not left
+ * pointing at the memory of a test that has finished.
+ */
+class variable_test : public stream_parser_fixture
+{
+protected:
+    void TearDown() override
+    {
+        variable::memory = nullptr;
+    }
+};
 
 namespace
 {
@@ -136,3 +149,19 @@ TEST_F(variable_test, operators)
 
     // TODO: the other operations are not tested as the behaviors are not yet clear
 }
+
+/**
+ * Tests that the memory set on one thread is the memory of every thread.
+ */
+TEST_F(variable_test, memory_shared_by_threads)
+{
+    int16_t memory = 0x1234;
+    istringstream stm("\x00"s);
+    stream_parser sp = parser(stm);
+
+    variable::memory = &memory;
+    variable v; sp >> v;
+
+    thread([&v] { v = 0x4321; }).join();
+    EXPECT_EQ(0x4321, memory);
+}
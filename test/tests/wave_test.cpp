@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+#include <brtools/data/wave/archive.h>
+#include <brtools/data/wave/wave.h>
+#include <brtools/error/integrity_error.h>
+#include <fixtures/file_writer.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using namespace std;
+using namespace brtools::data::wave;
+using brtools::data::encoding;
+using brtools::error::integrity_error;
+
+namespace dsp_adpcm = brtools::data::dsp_adpcm;
+
+namespace
+{
+    struct rwav_description
+    {
+        encoding enc          = encoding::adpcm;
+        bool     loops        = false;
+        uint32_t sample_rate  = 32000;
+        uint32_t loop_start   = 0;
+        uint32_t sample_count = 0;
+        vector<string>                  channel_data;
+        vector<dsp_adpcm::coefficients> coefs;
+    };
+
+    /**
+     * Positions of DSP-ADPCM waves are nibble addresses.
+     */
+    uint32_t position(const encoding enc, const uint32_t sample)
+    {
+        return enc == encoding::adpcm ? sample / 14 * 16 + sample % 14 + 2 : sample;
+    }
+
+    string make_rwav(const rwav_description& d)
+    {
+        const auto channel_count = uint32_t(d.channel_data.size());
+
+        ostringstream info_stm;
+        {
+            auto w = file_writer(info_stm);
+            w << uint8_t(d.enc) << uint8_t(d.loops) << uint8_t(channel_count)
+              << uint8_t(d.sample_rate >> 16) << uint16_t(d.sample_rate)
+              << uint8_t(0) << uint8_t(0)
+              << position(d.enc, d.loop_start) << position(d.enc, d.sample_count - 1)
+              << uint32_t(0x1C) << uint32_t(0) << uint32_t(0);
+
+            const auto channel_infos = 0x1C + 4 * channel_count;
+            const auto adpcm_infos   = channel_infos + 0x1C * channel_count;
+            uint32_t data_offset = 0;
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                w << uint32_t(channel_infos + 0x1C * c);
+            }
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                w << data_offset << uint32_t(adpcm_infos + 0x30 * c);
+                for (size_t i = 0; i < 5; ++i)
+                {
+                    w << uint32_t(0);
+                }
+                data_offset += uint32_t(d.channel_data[c].size());
+            }
+            for (uint32_t c = 0; c < channel_count; ++c)
+            {
+                const auto coefs = c < d.coefs.size() ? d.coefs[c] : dsp_adpcm::coefficients{};
+                for (const auto& pair : coefs.pairs)
+                {
+                    w << pair[0] << pair[1];
+                }
+                w << uint16_t(0) << uint16_t(0) << int16_t(c + 1) << int16_t(c + 2)
+                  << uint16_t(0) << int16_t(c + 3) << int16_t(c + 4) << uint16_t(0);
+            }
+        }
+
+        string data_body;
+        for (const auto& samples : d.channel_data)
+        {
+            data_body += samples;
+        }
+
+        const auto info = section("INFO", info_stm.str());
+        const auto data = section("DATA", data_body);
+
+        ostringstream stm;
+        auto w = file_writer(stm);
+        w.write_raw("RWAV", 4);
+        w << uint16_t(0xFEFF) << uint16_t(0x0102)
+          << uint32_t(0x20 + info.size() + data.size())
+          << uint16_t(0x20) << uint16_t(2)
+          << uint32_t(0x20) << uint32_t(info.size())
+          << uint32_t(0x20 + info.size()) << uint32_t(data.size());
+        pad(w, stm, 0x20);
+        return stm.str() + info + data;
+    }
+
+    string make_rwar(const vector<string>& waves)
+    {
+        ostringstream tabl_stm;
+        {
+            auto w = file_writer(tabl_stm);
+            w << uint32_t(waves.size());
+
+            // the waves follow the DATA section header, padded to 0x20
+            uint32_t offset = 0x20;
+            for (const auto& wave : waves)
+            {
+                w << uint8_t(1) << uint8_t(0) << uint16_t(0) << offset << uint32_t(wave.size());
+                offset += uint32_t(wave.size());
+            }
+        }
+
+        string data_body(0x18, '\0');
+        for (const auto& wave : waves)
+        {
+            data_body += wave;
+        }
+
+        const auto tabl = section("TABL", tabl_stm.str());
+        const auto data = section("DATA", data_body);
+
+        ostringstream stm;
+        auto w = file_writer(stm);
+        w.write_raw("RWAR", 4);
+        w << uint16_t(0xFEFF) << uint16_t(0x0100)
+          << uint32_t(0x20 + tabl.size() + data.size())
+          << uint16_t(0x20) << uint16_t(2)
+          << uint32_t(0x20) << uint32_t(tabl.size())
+          << uint32_t(0x20 + tabl.size()) << uint32_t(data.size());
+        pad(w, stm, 0x20);
+        return stm.str() + tabl + data;
+    }
+
+    rwav_description make_adpcm_description()
+    {
+        rwav_description d;
+        d.loops        = true;
+        d.sample_rate  = 0x01F400;
+        d.loop_start   = 30;
+        d.sample_count = 100;
+        for (size_t c = 0; c < 2; ++c)
+        {
+            string frames(dsp_adpcm::frame_bytes(d.sample_count), '\0');
+            for (size_t i = 0; i < frames.size(); ++i)
+            {
+                frames[i] = static_cast<char>(i % dsp_adpcm::frame_size == 0 ? 0x12 : i * 37 + c);
+            }
+            d.channel_data.push_back(frames);
+
+            dsp_adpcm::coefficients coefs = {};
+            coefs.pairs[1][0] = static_cast<int16_t>(1000 + c);
+            coefs.pairs[1][1] = -500;
+            d.coefs.push_back(coefs);
+        }
+        return d;
+    }
+}
+
+TEST(wave, info_and_samples_in_place)
+{
+    const auto d = make_adpcm_description();
+    const auto bytes = make_rwav(d);
+    const auto w = wave::make_wave(bytes.data(), bytes.size());
+
+    EXPECT_EQ(encoding::adpcm, w.wave_encoding());
+    EXPECT_EQ(0x01F400u, w.sample_rate());
+    EXPECT_EQ(2u, w.channel_count());
+    EXPECT_TRUE(w.loops());
+    EXPECT_EQ(30u, w.loop_start());
+    EXPECT_EQ(100u, w.sample_count());
+    EXPECT_EQ(dsp_adpcm::frame_bytes(100), w.sample_bytes());
+
+    const auto& right = w.channel_at(1);
+    EXPECT_EQ(1001, right.coefs.pairs[1][0]);
+    EXPECT_EQ(2, right.hist.previous);
+    EXPECT_EQ(3, right.hist.before_previous);
+    EXPECT_EQ(4, right.loop_hist.previous);
+    EXPECT_EQ(5, right.loop_hist.before_previous);
+
+    // the samples are where the file has them
+    EXPECT_GE(right.samples, bytes.data());
+    EXPECT_LE(right.samples + w.sample_bytes(), bytes.data() + bytes.size());
+    EXPECT_EQ(d.channel_data[1], string(right.samples, w.sample_bytes()));
+
+    const auto audio = w.decode();
+    ASSERT_EQ(100u, audio.frame_count());
+    vector<int16_t> expected(100);
+    dsp_adpcm::history hist = right.hist;
+    dsp_adpcm::decode(d.channel_data[1].data(), 100, right.coefs, hist, expected.data());
+    EXPECT_EQ(expected, vector<int16_t>(audio.channel(1), audio.channel(1) + 100));
+
+    EXPECT_THROW(w.channel_at(2), out_of_range);
+}
+
+TEST(wave, integrity_errors)
+{
+    {   // Test 1: file magic
+        auto bytes = make_rwav(make_adpcm_description());
+        bytes[3] = 'R';
+        EXPECT_THROW(wave::make_wave(bytes.data(), bytes.size()), integrity_error);
+    }
+
+    {   // Test 2: samples past the DATA section
+        auto d = make_adpcm_description();
+        d.channel_data[1].resize(8);
+        const auto bytes = make_rwav(d);
+        EXPECT_THROW(wave::make_wave(bytes.data(), bytes.size()), integrity_error);
+    }
+
+    {   // Test 3: the file is cut short
+        const auto bytes = make_rwav(make_adpcm_description());
+        EXPECT_THROW(wave::make_wave(bytes.data(), bytes.size() - 0x20), integrity_error);
+    }
+
+    {   // Test 4: a DATA section longer than the file, in the header and the section
+        auto bytes = make_rwav(make_adpcm_description());
+        const auto data = bytes.find("DATA");
+        bytes[0x1C]     = '\x7F';
+        bytes[data + 4] = '\x7F';
+        EXPECT_THROW(wave::make_wave(bytes.data(), bytes.size()), integrity_error);
+    }
+}
+
+TEST(archive, waves_in_place)
+{
+    rwav_description pcm16;
+    pcm16.enc          = encoding::pcm16;
+    pcm16.sample_rate  = 22050;
+    pcm16.sample_count = 4;
+    pcm16.channel_data.push_back(string("\x01\x00\xFF\xFF\x00\x02\x80\x00", 8));
+
+    rwav_description pcm8;
+    pcm8.enc          = encoding::pcm8;
+    pcm8.loops        = true;
+    pcm8.loop_start   = 2;
+    pcm8.sample_count = 3;
+    pcm8.channel_data.push_back("\x7F\x80\x01");
+
+    const auto bytes = make_rwar({ make_rwav(make_adpcm_description()), make_rwav(pcm16), make_rwav(pcm8) });
+    const auto a = archive::make_archive(bytes.data(), bytes.size());
+    ASSERT_EQ(3u, a.size());
+
+    {   // Test 1: DSP-ADPCM
+        const auto w = a.at(0);
+        EXPECT_EQ(encoding::adpcm, w.wave_encoding());
+        EXPECT_EQ(30u, w.loop_start());
+        EXPECT_EQ(1000, w.channel_at(0).coefs.pairs[1][0]);
+    }
+
+    {   // Test 2: big-endian 16-bit samples
+        const auto w = a.at(1);
+        EXPECT_EQ(encoding::pcm16, w.wave_encoding());
+        EXPECT_EQ(22050u, w.sample_rate());
+        EXPECT_FALSE(w.loops());
+        EXPECT_EQ(4u, w.sample_count());
+
+        const auto audio = w.decode();
+        EXPECT_EQ(0x0100, audio.channel(0)[0]);
+        EXPECT_EQ(-1, audio.channel(0)[1]);
+        EXPECT_EQ(-32768, audio.channel(0)[3]);
+        EXPECT_GE(w.channel_at(0).samples, bytes.data());
+        EXPECT_LT(w.channel_at(0).samples, bytes.data() + bytes.size());
+    }
+
+    {   // Test 3: 8-bit samples
+        const auto w = a.at(2);
+        EXPECT_TRUE(w.loops());
+        EXPECT_EQ(2u, w.loop_start());
+        EXPECT_EQ(3u, w.sample_count());
+        EXPECT_EQ(0x7F00, w.decode().channel(0)[0]);
+    }
+
+    EXPECT_THROW(a.at(3), out_of_range);
+}
+
+TEST(archive, integrity_errors)
+{
+    const auto bytes = make_rwar({ make_rwav(make_adpcm_description()) });
+
+    {   // Test 1: file magic
+        auto bad = bytes;
+        bad[0] = 'S';
+        EXPECT_THROW(archive::make_archive(bad.data(), bad.size()), integrity_error);
+    }
+
+    {   // Test 2: wave past the DATA section, as its length in the table
+        auto bad = bytes;
+        bad[0x20 + 0x14] = '\x7F';
+        EXPECT_THROW(archive::make_archive(bad.data(), bad.size()), integrity_error);
+    }
+
+    {   // Test 3: more entries than the table holds
+        auto bad = bytes;
+        bad[0x20 + 0x08] = '\x10';
+        EXPECT_THROW(archive::make_archive(bad.data(), bad.size()), integrity_error);
+    }
+}